@@ -38,6 +38,7 @@ int main(void)
 	OFFSET(CPUTHREAD_SAVE_R1, cpu_thread, save_r1);
 	OFFSET(CPUTHREAD_STATE, cpu_thread, state);
 	OFFSET(CPUTHREAD_CUR_TOKEN, cpu_thread, current_token);
+	OFFSET(CPUTHREAD_IN_OPAL_CALL, cpu_thread, in_opal_call);
 	DEFINE(CPUTHREAD_GAP, sizeof(struct cpu_thread) + STACK_SAFETY_GAP);
 #ifdef STACK_CHECK_ENABLED
 	OFFSET(CPUTHREAD_STACK_BOT_MARK, cpu_thread, stack_bot_mark);
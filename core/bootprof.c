@@ -0,0 +1,172 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define pr_fmt(fmt) "BOOTPROF: " fmt
+
+#include <skiboot.h>
+#include <lock.h>
+#include <timebase.h>
+#include <device.h>
+#include <bootprof.h>
+
+#ifdef __TEST__
+#define this_pir()	0
+#else
+#include <cpu.h>
+#define this_pir()	(this_cpu()->pir)
+#endif
+
+#define BOOTPROF_MAX_ENTRIES	1024
+
+/*
+ * Lives in the skiboot image, so it's in memory that is reserved from
+ * the OS and the OS can read it once it's up.
+ */
+static struct {
+	struct bootprof_hdr hdr;
+	struct bootprof_entry entries[BOOTPROF_MAX_ENTRIES];
+} bootprof;
+
+static struct lock bootprof_lock = LOCK_UNLOCKED;
+static struct bootprof_entry *bootprof_cur;
+static bool bootprof_done;
+
+/* Keeps the times going forward across the chiptod timebase reset */
+static uint64_t bootprof_tb_offset;
+static uint64_t bootprof_tb_before;
+static bool bootprof_tb_resetting;
+
+static struct bootprof_entry *bootprof_new(const char *name, u8 type,
+					   uint64_t start)
+{
+	struct bootprof_entry *e;
+	u32 nr = be32_to_cpu(bootprof.hdr.nr_entries);
+
+	if (nr >= BOOTPROF_MAX_ENTRIES) {
+		bootprof.hdr.dropped =
+			cpu_to_be32(be32_to_cpu(bootprof.hdr.dropped) + 1);
+		return NULL;
+	}
+
+	e = &bootprof.entries[nr];
+	e->start = cpu_to_be64(start);
+	e->end = 0;
+	e->pir = cpu_to_be32(this_pir());
+	e->type = type;
+	strncpy(e->name, name, BOOTPROF_NAME_LEN - 1);
+
+	/* The entry is complete before it's counted in */
+	lwsync();
+	bootprof.hdr.nr_entries = cpu_to_be32(nr + 1);
+	return e;
+}
+
+void bootprof_phase(const char *name)
+{
+	uint64_t now = mftb() + bootprof_tb_offset;
+
+	if (bootprof_done)
+		return;
+
+	lock(&bootprof_lock);
+	if (bootprof_cur)
+		bootprof_cur->end = cpu_to_be64(now);
+	bootprof_cur = name ? bootprof_new(name, BOOTPROF_PHASE, now) : NULL;
+	unlock(&bootprof_lock);
+}
+
+void bootprof_job(const char *name, uint64_t start)
+{
+	uint64_t now = mftb() + bootprof_tb_offset;
+	struct bootprof_entry *e;
+
+	if (bootprof_done)
+		return;
+
+	lock(&bootprof_lock);
+	start += bootprof_tb_offset;
+
+	/* Started on the old timebase and finished on the new one */
+	if (bootprof_tb_resetting || now < start) {
+		unlock(&bootprof_lock);
+		return;
+	}
+
+	e = bootprof_new(name, BOOTPROF_JOB, start);
+	if (e)
+		e->end = cpu_to_be64(now);
+	unlock(&bootprof_lock);
+}
+
+void bootprof_tb_reset_begin(void)
+{
+	if (bootprof_done)
+		return;
+
+	lock(&bootprof_lock);
+	bootprof_tb_before = mftb();
+	bootprof_tb_resetting = true;
+	unlock(&bootprof_lock);
+}
+
+void bootprof_tb_reset_end(void)
+{
+	lock(&bootprof_lock);
+	if (bootprof_tb_resetting) {
+		bootprof_tb_offset += bootprof_tb_before - mftb();
+		bootprof_tb_resetting = false;
+	}
+	unlock(&bootprof_lock);
+}
+
+void bootprof_reset(void)
+{
+	lock(&bootprof_lock);
+	memset(&bootprof, 0, sizeof(bootprof));
+	bootprof.hdr.magic = cpu_to_be32(BOOTPROF_MAGIC);
+	bootprof.hdr.version = cpu_to_be16(BOOTPROF_VERSION);
+	bootprof.hdr.entry_size = cpu_to_be16(sizeof(struct bootprof_entry));
+	bootprof.hdr.max_entries = cpu_to_be32(BOOTPROF_MAX_ENTRIES);
+	bootprof.hdr.tb_hz = cpu_to_be64(tb_hz);
+	bootprof_cur = NULL;
+	bootprof_done = false;
+	bootprof_tb_offset = 0;
+	bootprof_tb_resetting = false;
+	unlock(&bootprof_lock);
+}
+
+void bootprof_finish(void)
+{
+	bootprof_phase(NULL);
+
+	lock(&bootprof_lock);
+	/* Simulators change it after we've started */
+	bootprof.hdr.tb_hz = cpu_to_be64(tb_hz);
+	bootprof_done = true;
+	unlock(&bootprof_lock);
+
+	prlog(PR_INFO, "%u entries recorded, %u dropped\n",
+	      be32_to_cpu(bootprof.hdr.nr_entries),
+	      be32_to_cpu(bootprof.hdr.dropped));
+}
+
+#ifndef __TEST__
+void bootprof_export(struct dt_node *exports)
+{
+	dt_add_property_u64s(exports, "boot_profile", (uint64_t)&bootprof,
+			     sizeof(bootprof));
+}
+#endif
@@ -62,6 +62,15 @@ static inline unsigned int buddy_node_to_index(struct buddy *b,
 	return (node - start) << order;
 }
 
+/* Mark a node free, keeping the search hint for its order up to date */
+static void buddy_clr_node(struct buddy *b, unsigned int node,
+			   unsigned int order)
+{
+	bitmap_clr_bit(b->map, node);
+	if (node < b->freehints[order])
+		b->freehints[order] = node;
+}
+
 #ifdef BUDDY_DEBUG
 static void buddy_check_alloc(struct buddy *b, unsigned int node)
 {
@@ -88,7 +97,7 @@ static inline void buddy_check_alloc_down(struct buddy *b, unsigned int node) {}
 
 int buddy_alloc(struct buddy *b, unsigned int order)
 {
-	unsigned int o;
+	unsigned int o, start, end;
 	int node, index;
 
 	BUDDY_NOISE("buddy_alloc(%d)\n", order);
@@ -112,12 +121,14 @@ int buddy_alloc(struct buddy *b, unsigned int order)
 		    buddy_order_start(b, o),
 		    1u << (b->max_order - o));
 
-	/* Now find a free node */
-	node = bitmap_find_zero_bit(b->map, buddy_order_start(b, o),
-				    1u << (b->max_order - o));
+	/* Now find a free node, starting from the hint */
+	start = b->freehints[o];
+	end = buddy_order_start(b, o) << 1;
+	node = bitmap_find_zero_bit(b->map, start, end - start);
 
 	/* There should always be one */
 	assert(node >= 0);
+	b->freehints[o] = node + 1;
 
 	/* Mark it allocated and decrease free count */
 	bitmap_set_bit(b->map, node);
@@ -140,7 +151,7 @@ int buddy_alloc(struct buddy *b, unsigned int order)
 
 		BUDDY_NOISE("  order %d, using %d marking %d free\n",
 			    o, node, node ^ 1);
-		bitmap_clr_bit(b->map, node ^ 1);
+		buddy_clr_node(b, node ^ 1, o);
 		b->freecounts[o]++;
 		assert(bitmap_tst_bit(b->map, node));
 	}
@@ -199,7 +210,7 @@ bool buddy_reserve(struct buddy *b, unsigned int index, unsigned int order)
 
 		BUDDY_NOISE("  order %d, using %d marking %d free\n",
 			    o, freenode, freenode ^ 1);
-		bitmap_clr_bit(b->map, freenode ^ 1);
+		buddy_clr_node(b, freenode ^ 1, o);
 		b->freecounts[o]++;
 		assert(bitmap_tst_bit(b->map, node));
 	}
@@ -252,7 +263,7 @@ void buddy_free(struct buddy *b, unsigned int index, unsigned int order)
 	}
 
 	/* No more coalescing, mark it free */
-	bitmap_clr_bit(b->map, node);
+	buddy_clr_node(b, node, order);
 
 	/* Increase the freelist count for that level */
 	b->freecounts[order]++;
@@ -264,11 +275,14 @@ void buddy_free(struct buddy *b, unsigned int index, unsigned int order)
 void buddy_reset(struct buddy *b)
 {
 	unsigned int bsize = BITMAP_BYTES(1u << (b->max_order + 1));
+	unsigned int o;
 
 	BUDDY_NOISE("buddy_reset()\n");
 	/* We fill the bitmap with 1's to make it completely "busy" */
 	memset(b->map, 0xff, bsize);
 	memset(b->freecounts, 0, sizeof(b->freecounts));
+	for (o = 0; o <= b->max_order; o++)
+		b->freehints[o] = buddy_order_start(b, o) << 1;
 
 	/* We mark the root of the tree free, this is entry 1 as entry 0
 	 * is unused.
@@ -26,6 +26,126 @@
 #include "stdio.h"
 #include "console.h"
 #include "timebase.h"
+#include "trace.h"
+
+/*
+ * Binary logging. With TRACE_PRLOG set in the trace mask, messages that
+ * would only go to the in-memory console are recorded in the trace buffer
+ * of the current CPU as their format string address and raw arguments,
+ * which skips all the formatting. external/trace/dump_trace turns them
+ * back into text using the skiboot image.
+ *
+ * Returns false if the message can't be recorded that way (unsupported
+ * conversion, or too many/too long arguments), in which case the caller
+ * formats it as usual.
+ */
+static bool prlog_trace_arg(struct trace_prlog *t, unsigned int *pos,
+			    uint64_t v)
+{
+	__be64 bev = cpu_to_be64(v);
+
+	if (*pos + sizeof(bev) > TRACE_PRLOG_DATA_SZ)
+		return false;
+	memcpy(&t->data[*pos], &bev, sizeof(bev));
+	*pos += sizeof(bev);
+	return true;
+}
+
+static bool prlog_trace(int log_level, const char *fmt, va_list ap)
+{
+	union trace t;
+	unsigned int nargs = 0, pos = 0, len;
+	uint16_t str_mask = 0;
+	bool long_arg;
+	const char *p, *str;
+	uint64_t v;
+
+	/* Only the pointer is kept, so it has to outlive us */
+	if (!is_rodata(fmt))
+		return false;
+
+	for (p = fmt; *p; p++) {
+		if (*p != '%')
+			continue;
+		if (*++p == '%')
+			continue;
+
+		/* Flags, width and precision, '*' takes an int argument */
+		for (; *p && strchr("-+ #0123456789.*", *p); p++) {
+			if (*p != '*')
+				continue;
+			if (nargs == TRACE_PRLOG_MAX_ARGS)
+				return false;
+			if (!prlog_trace_arg(&t.prlog, &pos, va_arg(ap, int)))
+				return false;
+			nargs++;
+		}
+
+		/* Length modifiers, only the argument size matters to us */
+		long_arg = false;
+		for (; *p && strchr("hlLqjzt", *p); p++)
+			if (*p != 'h')
+				long_arg = true;
+
+		if (nargs == TRACE_PRLOG_MAX_ARGS)
+			return false;
+
+		switch (*p) {
+		case 'd':
+		case 'i':
+			if (long_arg)
+				v = va_arg(ap, long);
+			else
+				v = va_arg(ap, int);
+			break;
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'o':
+		case 'c':
+			if (long_arg)
+				v = va_arg(ap, unsigned long);
+			else
+				v = va_arg(ap, unsigned int);
+			break;
+		case 'p':
+			v = (unsigned long)va_arg(ap, void *);
+			break;
+		case 's':
+			str = va_arg(ap, const char *);
+			if (str && is_rodata(str)) {
+				v = (unsigned long)str;
+				break;
+			}
+			if (!str)
+				str = "(null)";
+			len = strlen(str) + 1;
+			if (pos + len > TRACE_PRLOG_DATA_SZ)
+				return false;
+			memcpy(&t.prlog.data[pos], str, len);
+			memset(&t.prlog.data[pos + len], 0,
+			       ALIGN_UP(len, 8) - len);
+			pos += ALIGN_UP(len, 8);
+			str_mask |= 1 << nargs;
+			nargs++;
+			continue;
+		default:
+			return false;
+		}
+		if (!prlog_trace_arg(&t.prlog, &pos, v))
+			return false;
+		nargs++;
+	}
+
+	t.prlog.fmt = cpu_to_be64((unsigned long)fmt);
+	t.prlog.level = log_level;
+	t.prlog.nargs = nargs;
+	t.prlog.str_mask = cpu_to_be16(str_mask);
+	memset(t.prlog.unused, 0, sizeof(t.prlog.unused));
+	trace_add(&t, TRACE_PRLOG, offsetof(struct trace_prlog, data) + pos);
+
+	return true;
+}
 
 static int vprlog(int log_level, const char *fmt, va_list ap)
 {
@@ -44,13 +164,25 @@ static int vprlog(int log_level, const char *fmt, va_list ap)
 	if (log_level > (debug_descriptor.console_log_levels >> 4))
 		return 0;
 
+	if (log_level > (debug_descriptor.console_log_levels & 0x0f))
+		flush_to_drivers = false;
+
+	if (!flush_to_drivers &&
+	    (debug_descriptor.trace_mask & (1ul << TRACE_PRLOG))) {
+		va_list aq;
+		bool done;
+
+		va_copy(aq, ap);
+		done = prlog_trace(log_level, fmt, aq);
+		va_end(aq);
+		if (done)
+			return 0;
+	}
+
 	count = snprintf(buffer, sizeof(buffer), "[%5lu.%09lu,%d] ",
 			 tb_to_secs(tb), tb_remaining_nsecs(tb), log_level);
 	count+= vsnprintf(buffer+count, sizeof(buffer)-count, fmt, ap);
 
-	if (log_level > (debug_descriptor.console_log_levels & 0x0f))
-		flush_to_drivers = false;
-
 	console_write(flush_to_drivers, buffer, count);
 
 	return count;
@@ -32,6 +32,23 @@ static size_t con_in;
 static size_t con_out;
 static bool con_wrapped;
 
+/*
+ * Memory-only messages written while the drivers still have output
+ * pending (the UART drains in the background) can't just move con_out
+ * past them, that would drop the pending output. Remember where they
+ * are instead and step over them when the drivers get there.
+ */
+#define CON_MAX_SKIPS	16
+
+static struct con_skip {
+	size_t start;
+	size_t end;
+} con_skips[CON_MAX_SKIPS];
+static unsigned int con_nr_skips;
+
+/* Set while a CPU is in the driver with con_lock dropped */
+static bool in_flush;
+
 /* Internal console driver ops */
 static struct con_ops *con_driver;
 
@@ -94,6 +111,86 @@ void clear_console(void)
 	memset(con_buf, 0, INMEM_CON_LEN);
 }
 
+/* Step con_out over any memory-only messages it has reached */
+static void con_skip_hidden(void)
+{
+	unsigned int i;
+
+	while (con_nr_skips && con_out == con_skips[0].start) {
+		con_out = con_skips[0].end;
+		con_nr_skips--;
+		for (i = 0; i < con_nr_skips; i++)
+			con_skips[i] = con_skips[i + 1];
+	}
+}
+
+/* How many times in a row the driver may take nothing while we drain */
+#define CON_DRAIN_STALLS	1000000
+
+static bool __flush_console(bool flush_to_drivers);
+
+/*
+ * A memory-only message is about to be copied in at con_in and there's
+ * no slot left to remember it by. Push the drivers along until they
+ * get past the oldest hidden message and free one up. That can't be
+ * done if another CPU is in the driver (it needs con_lock, which we
+ * hold, to finish) or flushing is suspended here, and we stop if the
+ * driver takes nothing for too long.
+ */
+static void con_drain_skips(void)
+{
+	struct cpu_thread *cpu = this_cpu();
+	unsigned int stalls = 0;
+	size_t out;
+
+	if (!con_driver || con_nr_skips < CON_MAX_SKIPS ||
+	    con_skips[CON_MAX_SKIPS - 1].end == con_in)
+		return;
+
+	while (con_nr_skips == CON_MAX_SKIPS && !in_flush &&
+	       !cpu->con_suspend && stalls < CON_DRAIN_STALLS) {
+		out = con_out;
+		__flush_console(true);
+		if (con_out == out)
+			stalls++;
+		else
+			stalls = 0;
+	}
+}
+
+/*
+ * Keep the message that was just copied in at start out of the drivers.
+ * One that directly follows the last hidden message just extends it.
+ * If the list is still full after con_drain_skips(), the last hidden
+ * message is stretched over this one, and the driver output in between
+ * only stays in the memory console: that's better than sending
+ * everything below console_log_levels to a slow UART.
+ */
+static void con_hide(size_t start)
+{
+	if (!con_driver)
+		return;
+
+	/*
+	 * A flush in progress on another CPU writes con_out back when it's
+	 * done, so only move it here when nobody is in the driver.
+	 */
+	if (con_out == start && !con_nr_skips && !in_flush) {
+		con_out = con_in;
+		return;
+	}
+
+	if (con_nr_skips && (con_skips[con_nr_skips - 1].end == start ||
+			     con_nr_skips == CON_MAX_SKIPS)) {
+		con_skips[con_nr_skips - 1].end = con_in;
+		return;
+	}
+
+	con_skips[con_nr_skips].start = start;
+	con_skips[con_nr_skips].end = con_in;
+	con_nr_skips++;
+}
+
 /*
  * Flush the console buffer into the driver, returns true
  * if there is more to go.
@@ -104,7 +201,7 @@ static bool __flush_console(bool flush_to_drivers)
 {
 	struct cpu_thread *cpu = this_cpu();
 	size_t req, len = 0;
-	static bool in_flush, more_flush;
+	static bool more_flush;
 
 	/* Is there anything to flush ? Bail out early if not */
 	if (con_in == con_out || !con_driver)
@@ -142,7 +239,6 @@ static bool __flush_console(bool flush_to_drivers)
 	 *     con_out.
 	 */
 	if (!flush_to_drivers) {
-		con_out = con_in;
 		in_flush = false;
 		return false;
 	}
@@ -150,12 +246,27 @@ static bool __flush_console(bool flush_to_drivers)
 	do {
 		more_flush = false;
 
+		con_skip_hidden();
+		if (con_out == con_in)
+			break;
+
 		if (con_out > con_in) {
 			req = INMEM_CON_OUT_LEN - con_out;
 			more_flush = true;
 		} else
 			req = con_in - con_out;
 
+		/* Stop short of the next memory-only message */
+		if (con_nr_skips) {
+			size_t skip = (con_skips[0].start + INMEM_CON_OUT_LEN -
+				       con_out) % INMEM_CON_OUT_LEN;
+
+			if (skip < req) {
+				req = skip;
+				more_flush = true;
+			}
+		}
+
 		unlock(&con_lock);
 		len = con_driver->write(con_buf + con_out, req);
 		lock(&con_lock);
@@ -182,18 +293,52 @@ bool flush_console(void)
 	return ret;
 }
 
-static void inmem_write(char c)
+/*
+ * Copy a chunk of output into the in-memory console ring. This doesn't
+ * make it visible to memcons readers, inmem_publish() does that once a
+ * whole record has been copied.
+ */
+static void inmem_copy(const char *buf, size_t len)
 {
-	uint32_t opos;
+	size_t room, chunk;
+	bool overrun;
 
-	if (!c)
+	if (!len)
 		return;
-	con_buf[con_in++] = c;
-	if (con_in >= INMEM_CON_OUT_LEN) {
-		con_in = 0;
-		con_wrapped = true;
+
+	/* Only the tail of anything larger than the buffer survives */
+	if (len >= INMEM_CON_OUT_LEN) {
+		buf += len - (INMEM_CON_OUT_LEN - 1);
+		len = INMEM_CON_OUT_LEN - 1;
+	}
+
+	/* Space left before the head catches up with the tail */
+	room = (con_out + INMEM_CON_OUT_LEN - con_in - 1) % INMEM_CON_OUT_LEN;
+	overrun = len > room;
+
+	while (len) {
+		chunk = MIN(len, INMEM_CON_OUT_LEN - con_in);
+		memcpy(con_buf + con_in, buf, chunk);
+		con_in += chunk;
+		if (con_in >= INMEM_CON_OUT_LEN) {
+			con_in = 0;
+			con_wrapped = true;
+		}
+		buf += chunk;
+		len -= chunk;
 	}
 
+	/* If head passed tail, push tail around & drop chars */
+	if (overrun) {
+		con_out = (con_in + 1) % INMEM_CON_OUT_LEN;
+		con_nr_skips = 0;
+	}
+}
+
+static void inmem_publish(void)
+{
+	uint32_t opos;
+
 	/*
 	 * We must always re-generate memcons.out_pos because
 	 * under some circumstances, the console script will
@@ -206,10 +351,6 @@ static void inmem_write(char c)
 		opos |= MEMCONS_OUT_POS_WRAP;
 	lwsync();
 	memcons.out_pos = opos;
-
-	/* If head reaches tail, push tail around & drop chars */
-	if (con_in == con_out)
-		con_out = (con_in + 1) % INMEM_CON_OUT_LEN;
 }
 
 static size_t inmem_read(char *buf, size_t req)
@@ -227,14 +368,6 @@ static size_t inmem_read(char *buf, size_t req)
 	return read;
 }
 
-static void write_char(char c)
-{
-#ifdef MAMBO_DEBUG_CONSOLE
-	mambo_console_write(&c, 1);
-#endif
-	inmem_write(c);
-}
-
 ssize_t console_write(bool flush_to_drivers, const void *buf, size_t count)
 {
 	/* We use recursive locking here as we can get called
@@ -242,13 +375,37 @@ ssize_t console_write(bool flush_to_drivers, const void *buf, size_t count)
 	 */
 	bool need_unlock = lock_recursive(&con_lock);
 	const char *cbuf = buf;
+	size_t left = count, seg, start = con_in;
+
+#ifdef MAMBO_DEBUG_CONSOLE
+	mambo_console_write(cbuf, count);
+#endif
 
-	while(count--) {
-		char c = *(cbuf++);
-		if (c == '\n')
-			write_char('\r');
-		write_char(c);
+	if (!flush_to_drivers)
+		con_drain_skips();
+
+	/*
+	 * Copy the record a line at a time, turning '\n' into "\r\n" and
+	 * dropping NULs, and only update memcons.out_pos once it's all in,
+	 * so readers see whole records and we pay for a single barrier.
+	 */
+	while (left) {
+		for (seg = 0; seg < left; seg++)
+			if (cbuf[seg] == '\n' || cbuf[seg] == '\0')
+				break;
+		inmem_copy(cbuf, seg);
+		if (seg < left) {
+			if (cbuf[seg] == '\n')
+				inmem_copy("\r\n", 2);
+			seg++;
+		}
+		cbuf += seg;
+		left -= seg;
 	}
+	inmem_publish();
+
+	if (!flush_to_drivers)
+		con_hide(start);
 
 	__flush_console(flush_to_drivers);
 
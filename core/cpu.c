@@ -32,6 +32,7 @@
 #include <ccan/str/str.h>
 #include <ccan/container_of/container_of.h>
 #include <xscom.h>
+#include <bootprof.h>
 
 /* The cpu_threads array is static and indexed by PIR in
  * order to speed up lookup from asm entry points
@@ -194,7 +195,10 @@ struct cpu_job *__cpu_queue_job(struct cpu_thread *cpu,
 
 	/* Can't be scheduled, run it now */
 	if (cpu == NULL) {
+		uint64_t start = mftb();
+
 		func(data);
+		bootprof_job(name, start);
 		job->complete = true;
 		return job;
 	}
@@ -266,6 +270,7 @@ void cpu_process_jobs(void)
 	lock(&cpu->job_lock);
 	while (true) {
 		bool no_return;
+		uint64_t start;
 
 		job = list_pop(&cpu->job_queue, struct cpu_job, link);
 		if (!job)
@@ -278,7 +283,10 @@ void cpu_process_jobs(void)
 		prlog(PR_TRACE, "running job %s on %x\n", job->name, cpu->pir);
 		if (no_return)
 			free(job);
+		start = mftb();
 		func(data);
+		if (!no_return)
+			bootprof_job(job->name, start);
 		lock(&cpu->job_lock);
 		if (!no_return) {
 			cpu->job_count--;
@@ -453,6 +461,75 @@ void cpu_process_local_jobs(void)
 }
 
 
+struct cpu_chip_job {
+	struct proc_chip *chip;
+	bool (*fn)(struct proc_chip *chip);
+	struct cpu_job *job;
+	uint64_t start;
+	uint64_t end;
+	bool ok;
+};
+
+static void cpu_chip_job(void *data)
+{
+	struct cpu_chip_job *cj = data;
+
+	cj->start = mftb();
+	cj->ok = cj->fn(cj->chip);
+	cj->end = mftb();
+}
+
+bool cpu_do_chip_jobs(const char *name, bool (*fn)(struct proc_chip *chip))
+{
+	struct cpu_chip_job *cjs;
+	struct proc_chip *chip;
+	uint64_t start, slowest = 0;
+	uint32_t slowest_id = 0;
+	int i, nr = 0;
+	bool ok = true;
+
+	for_each_chip(chip)
+		nr++;
+	if (!nr)
+		return true;
+
+	cjs = zalloc(sizeof(*cjs) * nr);
+	assert(cjs);
+
+	start = mftb();
+	i = 0;
+	for_each_chip(chip) {
+		cjs[i].chip = chip;
+		cjs[i].fn = fn;
+		cjs[i].job = __cpu_queue_job(NULL, name, cpu_chip_job,
+					     &cjs[i], false);
+		assert(cjs[i].job);
+		i++;
+	}
+
+	/* If no secondary CPUs, do everything sync */
+	cpu_process_local_jobs();
+
+	for (i = 0; i < nr; i++) {
+		cpu_wait_job(cjs[i].job, true);
+		if (!cjs[i].ok)
+			ok = false;
+		if (cjs[i].end - cjs[i].start >= slowest) {
+			slowest = cjs[i].end - cjs[i].start;
+			slowest_id = cjs[i].chip->id;
+		}
+		prlog(PR_DEBUG, "CPU: %s chip %x took %lu ms\n", name,
+		      cjs[i].chip->id, tb_to_msecs(cjs[i].end - cjs[i].start));
+	}
+	free(cjs);
+
+	prlog(PR_INFO, "CPU: %s on %d chips took %lu ms (chip %x %lu ms)\n",
+	      name, nr, tb_to_msecs(mftb() - start), slowest_id,
+	      tb_to_msecs(slowest));
+	return ok;
+}
+
+
 struct dt_node *get_cpu_node(u32 pir)
 {
 	struct cpu_thread *t = find_cpu_by_pir(pir);
@@ -1022,6 +1099,9 @@ static int64_t opal_return_cpu(void)
 {
 	prlog(PR_DEBUG, "OPAL: Returning CPU 0x%04x\n", this_cpu()->pir);
 
+	/* We never go back out through opal_entry */
+	this_cpu()->in_opal_call--;
+
 	__secondary_cpu_entry();
 
 	return OPAL_HARDWARE; /* Should not happen */
@@ -0,0 +1,341 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define pr_fmt(fmt) "XZ: " fmt
+
+#include <skiboot.h>
+#include <cpu.h>
+#include <timebase.h>
+#include <decompress.h>
+
+/*
+ * An XZ stream is a header, a run of independently compressed blocks,
+ * an index giving the compressed and uncompressed size of each block,
+ * and a footer that says where the index starts. libxz only decodes
+ * whole streams, so to decode a block on its own we wrap it in a
+ * stream of one: the original header, the block, and a one record
+ * index and footer made up to match.
+ */
+#define XZ_HDR_SIZE		12
+#define XZ_FOOTER_SIZE		12
+#define XZ_VLI_MAX_BYTES	9
+
+/* Largest index + footer of a one block stream */
+#define XZ_TAIL_MAX		(4 + 3 * XZ_VLI_MAX_BYTES + 3 + 4 + XZ_FOOTER_SIZE)
+
+/*
+ * Each block job decodes from its own copy of the block, so only hand
+ * out this much compressed input at once to keep clear of the heap.
+ */
+#define XZ_INFLIGHT_MAX		(2 << 20)
+
+struct xz_block {
+	const uint8_t *hdr;
+	const uint8_t *in;
+	uint64_t unpadded;
+	uint64_t in_size;
+	uint8_t *out;
+	uint64_t out_size;
+	struct cpu_job *job;
+	int rc;
+	bool no_mem;
+};
+
+static uint32_t xz_get_le32(const uint8_t *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void xz_put_le32(uint8_t *p, uint32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+static int xz_get_vli(const uint8_t **p, const uint8_t *end, uint64_t *v)
+{
+	int i;
+
+	*v = 0;
+	for (i = 0; i < XZ_VLI_MAX_BYTES && *p < end; i++) {
+		*v |= (uint64_t)(**p & 0x7f) << (i * 7);
+		if (!(*(*p)++ & 0x80))
+			return 0;
+	}
+	return -1;
+}
+
+static int xz_put_vli(uint8_t *p, uint64_t v)
+{
+	int n = 0;
+
+	while (v >= 0x80) {
+		p[n++] = v | 0x80;
+		v >>= 7;
+	}
+	p[n++] = v;
+	return n;
+}
+
+/* Build the index and footer of a stream holding just this block */
+static size_t xz_block_tail(struct xz_block *blk, uint8_t *tail)
+{
+	size_t n = 0, isize;
+
+	tail[n++] = 0;
+	n += xz_put_vli(tail + n, 1);
+	n += xz_put_vli(tail + n, blk->unpadded);
+	n += xz_put_vli(tail + n, blk->out_size);
+	while (n & 3)
+		tail[n++] = 0;
+	xz_put_le32(tail + n, xz_crc32(tail, n, 0));
+	n += 4;
+	isize = n;
+
+	xz_put_le32(tail + n + 4, isize / 4 - 1);
+	memcpy(tail + n + 8, blk->hdr + 6, 2);
+	xz_put_le32(tail + n, xz_crc32(tail + n + 4, 6, 0));
+	memcpy(tail + n + 10, "YZ", 2);
+
+	return n + XZ_FOOTER_SIZE;
+}
+
+static void xz_decompress_block(void *data)
+{
+	struct xz_block *blk = data;
+	uint8_t tail[XZ_TAIL_MAX];
+	size_t tail_size;
+	struct xz_dec *s;
+	struct xz_buf b;
+	uint8_t *in;
+
+	blk->rc = -1;
+	tail_size = xz_block_tail(blk, tail);
+
+	/* Single call mode wants the input in one piece */
+	in = malloc(XZ_HDR_SIZE + blk->in_size + tail_size);
+	if (!in) {
+		blk->no_mem = true;
+		return;
+	}
+	memcpy(in, blk->hdr, XZ_HDR_SIZE);
+	memcpy(in + XZ_HDR_SIZE, blk->in, blk->in_size);
+	memcpy(in + XZ_HDR_SIZE + blk->in_size, tail, tail_size);
+
+	s = xz_dec_init(XZ_SINGLE, 0);
+	if (!s) {
+		blk->no_mem = true;
+		goto out;
+	}
+
+	b.in = in;
+	b.in_pos = 0;
+	b.in_size = XZ_HDR_SIZE + blk->in_size + tail_size;
+	b.out = blk->out;
+	b.out_pos = 0;
+	b.out_size = blk->out_size;
+
+	if (xz_dec_run(s, &b) == XZ_STREAM_END && b.out_pos == blk->out_size)
+		blk->rc = 0;
+
+	xz_dec_end(s);
+out:
+	free(in);
+}
+
+/*
+ * Read the block sizes out of the index. Returns the number of blocks,
+ * or -1 if this isn't a single, well formed stream we can split up.
+ */
+static int xz_parse_index(const uint8_t *src, size_t src_size,
+			  struct xz_block **blocks, uint64_t *total)
+{
+	const uint8_t *footer, *index, *p, *end;
+	uint64_t count, i, isize, in_off, out_off;
+	struct xz_block *blk;
+
+	/* Stream padding, a multiple of four zero bytes */
+	while (src_size >= 4 && !xz_get_le32(src + src_size - 4))
+		src_size -= 4;
+	if (src_size < XZ_HDR_SIZE + XZ_FOOTER_SIZE)
+		return -1;
+
+	footer = src + src_size - XZ_FOOTER_SIZE;
+	if (memcmp(footer + 10, "YZ", 2) ||
+	    xz_get_le32(footer) != xz_crc32(footer + 4, 6, 0) ||
+	    memcmp(footer + 8, src + 6, 2))
+		return -1;
+
+	isize = ((uint64_t)xz_get_le32(footer + 4) + 1) * 4;
+	if (isize > src_size - XZ_HDR_SIZE - XZ_FOOTER_SIZE)
+		return -1;
+	index = footer - isize;
+	end = footer - 4;
+	if (index[0] || xz_get_le32(end) != xz_crc32(index, isize - 4, 0))
+		return -1;
+
+	p = index + 1;
+	if (xz_get_vli(&p, end, &count) || !count || count > isize / 2)
+		return -1;
+
+	*blocks = blk = zalloc(count * sizeof(*blk));
+	if (!blk)
+		return -1;
+
+	in_off = XZ_HDR_SIZE;
+	out_off = 0;
+	for (i = 0; i < count; i++) {
+		if (xz_get_vli(&p, end, &blk[i].unpadded) ||
+		    xz_get_vli(&p, end, &blk[i].out_size))
+			goto fail;
+		blk[i].hdr = src;
+		blk[i].in = src + in_off;
+		blk[i].in_size = ALIGN_UP(blk[i].unpadded, 4);
+		in_off += blk[i].in_size;
+		out_off += blk[i].out_size;
+		if (in_off > (uint64_t)(index - src))
+			goto fail;
+	}
+	if (in_off != (uint64_t)(index - src))
+		goto fail;
+
+	*total = out_off;
+	return count;
+fail:
+	free(blk);
+	return -1;
+}
+
+static int xz_decompress_serial(void *dst, size_t dst_size, const void *src,
+				size_t src_size, size_t *out_size)
+{
+	struct xz_dec *s;
+	struct xz_buf b;
+	int ret;
+
+	s = xz_dec_init(XZ_SINGLE, 0);
+	if (!s) {
+		prerror("initialization error for xz\n");
+		return -1;
+	}
+
+	b.in = src;
+	b.in_pos = 0;
+	b.in_size = src_size;
+	b.out = dst;
+	b.out_pos = 0;
+	b.out_size = dst_size;
+
+	ret = xz_dec_run(s, &b);
+	xz_dec_end(s);
+	if (ret != XZ_STREAM_END) {
+		prerror("failed to decompress, error %d\n", ret);
+		return -1;
+	}
+
+	if (out_size)
+		*out_size = b.out_pos;
+	return 0;
+}
+
+/*
+ * Queue jobs for blocks from next on, until XZ_INFLIGHT_MAX of input is
+ * out (always at least one). Returns the first block not queued.
+ */
+static int xz_queue_blocks(struct xz_block *blocks, int nr, int next,
+			   uint64_t *inflight)
+{
+	while (next < nr && (!*inflight ||
+	       *inflight + blocks[next].in_size <= XZ_INFLIGHT_MAX)) {
+		blocks[next].job = cpu_queue_job(NULL, "xz_decompress_block",
+						 xz_decompress_block,
+						 &blocks[next]);
+		*inflight += blocks[next].in_size;
+		next++;
+	}
+	return next;
+}
+
+int xz_decompress(void *dst, size_t dst_size, const void *src,
+		  size_t src_size, size_t *out_size)
+{
+	struct xz_block *blocks;
+	uint64_t total, inflight = 0, start = mftb();
+	int i, next, nr, rc = 0;
+	bool no_mem = false;
+
+	xz_crc32_init();
+
+	nr = xz_parse_index(src, src_size, &blocks, &total);
+	if (nr < 2) {
+		if (nr == 1)
+			free(blocks);
+		return xz_decompress_serial(dst, dst_size, src, src_size,
+					    out_size);
+	}
+
+	if (total > dst_size) {
+		prerror("stream won't fit in %zu bytes\n", dst_size);
+		free(blocks);
+		return -1;
+	}
+
+	blocks[0].out = dst;
+	for (i = 1; i < nr; i++)
+		blocks[i].out = blocks[i - 1].out + blocks[i - 1].out_size;
+
+	/* Hand out the other blocks while we do the first one ourselves */
+	next = xz_queue_blocks(blocks, nr, 1, &inflight);
+	xz_decompress_block(&blocks[0]);
+
+	for (i = 1; i < nr; i++) {
+		if (blocks[i].job)
+			cpu_wait_job(blocks[i].job, true);
+		else
+			xz_decompress_block(&blocks[i]);
+		inflight -= blocks[i].in_size;
+		next = xz_queue_blocks(blocks, nr, next, &inflight);
+	}
+
+	for (i = 0; i < nr; i++) {
+		if (blocks[i].no_mem)
+			no_mem = true;
+		if (blocks[i].rc)
+			rc = -1;
+	}
+	free(blocks);
+
+	/* The serial decoder works in place, no copies */
+	if (no_mem) {
+		prlog(PR_WARNING, "out of memory for parallel blocks, "
+		      "decompressing serially\n");
+		return xz_decompress_serial(dst, dst_size, src, src_size,
+					    out_size);
+	}
+
+	if (rc) {
+		prerror("failed to decompress\n");
+		return -1;
+	}
+
+	prlog(PR_DEBUG, "%zu bytes in %d blocks in %lu ms\n", (size_t)total,
+	      nr, tb_to_msecs(mftb() - start));
+	if (out_size)
+		*out_size = total;
+	return 0;
+}
@@ -112,6 +112,19 @@ bool dt_attach_root(struct dt_node *parent, struct dt_node *root)
 		return true;
 	}
 
+	/*
+	 * Nodes are mostly created in order (HDAT parsing adds thousands
+	 * of CPUs, caches and VPD nodes this way), so check the end first
+	 * rather than walking every sibling each time.
+	 */
+	node = list_tail(&parent->children, struct dt_node, list);
+	if (dt_cmp_subnodes(node, root) < 0) {
+		list_add_tail(&parent->children, &root->list);
+		root->parent = parent;
+
+		return true;
+	}
+
 	dt_for_each_child(parent, node) {
 		int cmp = dt_cmp_subnodes(node, root);
 
@@ -23,6 +23,8 @@
 #include <lock.h>
 #include <errorlog.h>
 #include <pool.h>
+#include <timer.h>
+#include <timebase.h>
 
 /*
  * Maximum number buffers that are pre-allocated
@@ -42,6 +44,32 @@ static struct lock elog_lock = LOCK_UNLOCKED;
 
 static bool elog_available = false;
 
+/*
+ * Committed logs are held on elog_pending for ELOG_COALESCE_MS before
+ * they go to the platform backend (which builds the PEL), from a timer
+ * rather than from whoever hit the error. During an error storm a log
+ * with the same reason and the same user data as one still pending is
+ * folded into it and only bumps its occurrence count, so the backend
+ * gets one PEL per distinct event rather than one per occurrence. Logs
+ * that differ only in their user data (which unit, which register
+ * dump) are kept apart. Panics skip the queue, and reboot, xstop and
+ * terminate call elog_flush_pending() so nothing is left behind. The
+ * PLID of a merged log is that of the pending one it was folded into.
+ */
+#define ELOG_COALESCE_MS		100
+
+/* User data section tag carrying the occurrence count: "OCCR" */
+#define ELOG_OCCURRENCE_TAG		0x4f434352
+
+/*
+ * Pending logs, oldest first. Not a list through elog->link: that's
+ * for the backends, and struct errorlog is packed.
+ */
+static struct errorlog *elog_pending[ELOG_WRITE_MAX_RECORD];
+static unsigned int elog_nr_pending;
+static struct timer elog_timer;
+static unsigned long elog_nr_committed, elog_nr_merged, elog_nr_dropped;
+
 static struct errorlog *get_write_buffer(int opal_event_severity)
 {
 	struct errorlog *buf;
@@ -55,6 +83,13 @@ static struct errorlog *get_write_buffer(int opal_event_severity)
 	else
 		buf = pool_get(&elog_pool, POOL_NORMAL);
 
+	/* Only shout about it now and then, this happens in storms */
+	if (!buf) {
+		elog_nr_dropped++;
+		if (!(elog_nr_dropped & (elog_nr_dropped - 1)))
+			prerror("ELOG: Out of buffers, %lu logs dropped\n",
+				elog_nr_dropped);
+	}
 	unlock(&elog_lock);
 	return buf;
 }
@@ -122,22 +157,163 @@ void opal_elog_complete(struct errorlog *buf, bool success)
 	unlock(&elog_lock);
 }
 
-void log_commit(struct errorlog *elog)
+static void __log_commit(struct errorlog *elog)
 {
 	int rc;
 
-	if (!elog)
-		return;
+	rc = platform.elog_commit(elog);
+	if (rc)
+		prerror("ELOG: Platform commit error %d\n", rc);
+}
 
-	if (platform.elog_commit) {
-		rc = platform.elog_commit(elog);
-		if (rc)
-			prerror("ELOG: Platform commit error %d\n", rc);
+static bool elog_same_event(struct errorlog *a, struct errorlog *b)
+{
+	return a->reason_code == b->reason_code &&
+		a->component_id == b->component_id &&
+		a->subsystem_id == b->subsystem_id &&
+		a->event_severity == b->event_severity &&
+		a->user_section_count == b->user_section_count &&
+		a->user_section_size == b->user_section_size &&
+		!memcmp(a->user_data_dump, b->user_data_dump,
+			a->user_section_size);
+}
 
+static void elog_add_occurrences(struct errorlog *elog)
+{
+	char msg[64];
+	int len;
+
+	len = snprintf(msg, sizeof(msg), "Occurred %d times in %lu ms",
+		       elog->occurrences,
+		       tb_to_msecs(elog->last_tb - elog->commit_tb));
+	log_add_section(elog, ELOG_OCCURRENCE_TAG);
+	log_append_data(elog, (unsigned char *)msg, len);
+}
+
+/*
+ * Hand the pending logs to the backend, all of them or only those that
+ * have been held for the whole window by now. Called with elog_lock
+ * held, which it drops.
+ */
+static void __elog_flush_pending(uint64_t now, bool all)
+{
+	uint64_t window = msecs_to_tb(ELOG_COALESCE_MS);
+	struct errorlog *ready[ELOG_WRITE_MAX_RECORD];
+	struct errorlog *elog;
+	unsigned int i, nr = 0;
+
+	while (nr < elog_nr_pending) {
+		elog = elog_pending[nr];
+		if (!all && tb_compare(now, elog->commit_tb + window) ==
+		    TB_ABEFOREB) {
+			schedule_timer_at(&elog_timer, elog->commit_tb + window);
+			break;
+		}
+		ready[nr++] = elog;
+	}
+	elog_nr_pending -= nr;
+	memmove(elog_pending, elog_pending + nr,
+		elog_nr_pending * sizeof(elog_pending[0]));
+	unlock(&elog_lock);
+
+	/* The backends take their own locks and may complete inline */
+	for (i = 0; i < nr; i++) {
+		elog = ready[i];
+		if (elog->occurrences > 1) {
+			prlog(PR_DEBUG, "ELOG: Reason 0x%x logged %d times\n",
+			      elog->reason_code, elog->occurrences);
+			elog_add_occurrences(elog);
+		}
+		__log_commit(elog);
+	}
+}
+
+static void elog_timer_expiry(struct timer *t __unused, void *data __unused,
+			      uint64_t now)
+{
+	lock(&elog_lock);
+	__elog_flush_pending(now, false);
+}
+
+/*
+ * Commit everything that's pending now, for when we're about to reboot,
+ * checkstop or terminate and the timer won't get to run. It can be
+ * reached from anywhere on the way to abort, so don't wait for the lock.
+ */
+void elog_flush_pending(void)
+{
+	if (!elog_available || !try_lock(&elog_lock))
 		return;
+	__elog_flush_pending(0, true);
+}
+
+/*
+ * Queue a log for the backend and return the PLID it will go out
+ * under, which is not elog's own if it got merged.
+ */
+static uint32_t __elog_queue(struct errorlog *elog)
+{
+	uint32_t plid = elog->plid;
+	unsigned int i;
+	bool first;
+
+	if (!platform.elog_commit) {
+		opal_elog_complete(elog, false);
+		return plid;
+	}
+
+	/* We may not be around for long enough to run the timer */
+	if (elog->event_severity == OPAL_ERROR_PANIC) {
+		elog_nr_committed++;
+		__log_commit(elog);
+		return plid;
+	}
+
+	lock(&elog_lock);
+	elog_nr_committed++;
+	for (i = 0; i < elog_nr_pending; i++) {
+		struct errorlog *p = elog_pending[i];
+
+		if (elog_same_event(p, elog)) {
+			p->occurrences++;
+			p->last_tb = mftb();
+			elog_nr_merged++;
+			plid = p->plid;
+			pool_free_object(&elog_pool, elog);
+			unlock(&elog_lock);
+			return plid;
+		}
+	}
+
+	/* Can't happen, it's as big as the pool, but don't lose it */
+	if (elog_nr_pending == ELOG_WRITE_MAX_RECORD) {
+		unlock(&elog_lock);
+		__log_commit(elog);
+		return plid;
 	}
 
-	opal_elog_complete(elog, false);
+	first = !elog_nr_pending;
+	elog->occurrences = 1;
+	elog->commit_tb = elog->last_tb = mftb();
+	elog_pending[elog_nr_pending++] = elog;
+	unlock(&elog_lock);
+
+	if (first)
+		schedule_timer(&elog_timer, msecs_to_tb(ELOG_COALESCE_MS));
+
+	return plid;
+}
+
+void log_commit(struct errorlog *elog)
+{
+	if (elog)
+		__elog_queue(elog);
+}
+
+void elog_dump_stats(void)
+{
+	prlog(PR_INFO, "ELOG: %lu committed, %lu merged, %lu dropped\n",
+	      elog_nr_committed, elog_nr_merged, elog_nr_dropped);
 }
 
 void log_append_data(struct errorlog *buf, unsigned char *data, uint16_t size)
@@ -216,9 +392,8 @@ uint32_t log_simple_error(struct opal_err_info *e_info, const char *fmt, ...)
 	}
 
 	log_append_data(buf, err_msg, strlen(err_msg));
-	log_commit(buf);
 
-	return buf->plid;
+	return __elog_queue(buf);
 }
 
 int elog_init(void)
@@ -228,6 +403,7 @@ int elog_init(void)
 					ELOG_WRITE_MAX_RECORD, 1))
 		return OPAL_RESOURCE;
 
+	init_timer(&elog_timer, elog_timer_expiry, NULL);
 	elog_available = true;
 	return 0;
 }
@@ -27,12 +27,26 @@
 #include <chip.h>
 #include <chiptod.h>
 #include <ipmi.h>
+#include <xive.h>
+#include <bootprof.h>
 
 #define P8_EX_TCTL_DIRECT_CONTROLS(t)	(0x10013000 + (t) * 0x10)
 #define P8_DIRECT_CTL_STOP		PPC_BIT(63)
 #define P8_DIRECT_CTL_PRENAP		PPC_BIT(47)
 #define P8_DIRECT_CTL_SRESET		PPC_BIT(60)
 
+/* P9 core direct controls and special wakeup, use XSCOM_ADDR_P9_EC */
+#define P9_RAS_STATUS			0x10a02
+#define P9_THREAD_QUIESCED(t)		PPC_BITMASK(0 + 8*(t), 3 + 8*(t))
+#define P9_EC_DIRECT_CONTROLS		0x10a9c
+#define P9_THREAD_STOP(t)		PPC_BIT(7 + 8*(t))
+#define P9_THREAD_SRESET(t)		PPC_BIT(4 + 8*(t))
+#define P9_EC_PPM_SSHHYP		0x0114
+#define P9_SPECIAL_WKUP_DONE		PPC_BIT(1)
+#define P9_SPWKUP_SET			PPC_BIT(0)
+
+/* How long we give other CPUs to leave OPAL before giving up */
+#define FAST_REBOOT_OPAL_EXIT_TIMEOUT	1000	/* ms */
 
 /* Flag tested by the OPAL entry code */
 uint8_t reboot_in_progress;
@@ -40,6 +54,89 @@ static volatile bool fast_boot_release;
 static struct cpu_thread *last_man_standing;
 static struct lock reset_lock = LOCK_UNLOCKED;
 
+/* Timebase at the end of each phase, for the report at the end */
+static struct {
+	uint64_t start;
+	uint64_t opal_exit;
+	uint64_t reset;
+	uint64_t callin;
+	uint64_t cleanup;
+	uint64_t pci;
+} fr_tb;
+
+/*
+ * On P9 asserting special wakeup and waiting for it are split, so that
+ * we can assert it on all cores and then wait for them all together.
+ */
+static int p9_assert_special_wakeup(struct cpu_thread *cpu)
+{
+	uint32_t chip_id = pir_to_chip_id(cpu->pir);
+	uint32_t core_id = pir_to_core_id(cpu->pir);
+	int rc;
+
+	prlog(PR_DEBUG, "RESET Waking up core 0x%x\n", core_id);
+
+	rc = xscom_write(chip_id,
+			 XSCOM_ADDR_P9_EC_SLAVE(core_id, EC_PPM_SPECIAL_WKUP_HYP),
+			 P9_SPWKUP_SET);
+	if (rc) {
+		prerror("RESET: XSCOM error %d asserting special"
+			" wakeup on 0x%x\n", rc, cpu->pir);
+		return rc;
+	}
+	return 0;
+}
+
+static int p9_wait_special_wakeup(struct cpu_thread *cpu, uint64_t stamp)
+{
+	uint32_t chip_id = pir_to_chip_id(cpu->pir);
+	uint32_t core_id = pir_to_core_id(cpu->pir);
+	uint64_t val, poll_target;
+	int rc;
+
+	/* Same 200ms timeout as the P8 HWP, see set_special_wakeup() */
+	poll_target = stamp + msecs_to_tb(200);
+	for (;;) {
+		rc = xscom_read(chip_id,
+				XSCOM_ADDR_P9_EC_SLAVE(core_id, P9_EC_PPM_SSHHYP),
+				&val);
+		if (rc) {
+			prerror("RESET: XSCOM error %d reading PM state on"
+				" 0x%x\n", rc, cpu->pir);
+			return rc;
+		}
+		if (val & P9_SPECIAL_WKUP_DONE) {
+			prlog(PR_TRACE, "RESET: Special wakeup complete after"
+			      " %ld us\n", tb_to_usecs(mftb() - stamp));
+			return 0;
+		}
+		if (mftb() > poll_target)
+			break;
+		time_wait_us(1);
+	}
+
+	prerror("RESET: Timeout on special wakeup of 0x%0x\n", cpu->pir);
+	prerror("RESET:   SSHHYP = 0x%016llx\n", val);
+	return OPAL_HARDWARE;
+}
+
+static int p9_clr_special_wakeup(struct cpu_thread *cpu)
+{
+	uint32_t chip_id = pir_to_chip_id(cpu->pir);
+	uint32_t core_id = pir_to_core_id(cpu->pir);
+	int rc;
+
+	rc = xscom_write(chip_id,
+			 XSCOM_ADDR_P9_EC_SLAVE(core_id, EC_PPM_SPECIAL_WKUP_HYP),
+			 0);
+	if (rc) {
+		prerror("RESET: XSCOM error %d deasserting"
+			" special wakeup on 0x%x\n", rc, cpu->pir);
+		return rc;
+	}
+	return 0;
+}
+
 static int set_special_wakeup(struct cpu_thread *cpu)
 {
 	uint64_t val, poll_target, stamp;
@@ -170,6 +267,8 @@ static int clr_special_wakeup(struct cpu_thread *cpu)
 	prlog(PR_DEBUG, "RESET: Releasing core 0x%x wakeup\n", core_id);
 	if (chip_quirk(QUIRK_MAMBO_CALLOUTS))
 		return OPAL_SUCCESS;
+	if (proc_gen == proc_gen_p9)
+		return p9_clr_special_wakeup(cpu);
 
 	/*
 	 * The original HWp reads the XSCOM first but ignores the result
@@ -295,6 +394,158 @@ static bool fast_reset_p8(void)
 	return true;
 }
 
+static int p9_stop_thread(struct cpu_thread *cpu)
+{
+	uint32_t chip_id = pir_to_chip_id(cpu->pir);
+	uint32_t core_id = pir_to_core_id(cpu->pir);
+	uint32_t thread_id = pir_to_thread_id(cpu->pir);
+	uint64_t val, poll_target;
+	int rc;
+
+	rc = xscom_write(chip_id, XSCOM_ADDR_P9_EC(core_id,
+						   P9_EC_DIRECT_CONTROLS),
+			 P9_THREAD_STOP(thread_id));
+	if (rc) {
+		prerror("RESET: XSCOM error %d stopping 0x%x\n", rc, cpu->pir);
+		return rc;
+	}
+
+	/* The thread has to quiesce before we can reset it */
+	poll_target = mftb() + msecs_to_tb(10);
+	do {
+		rc = xscom_read(chip_id, XSCOM_ADDR_P9_EC(core_id,
+							  P9_RAS_STATUS),
+				&val);
+		if (rc) {
+			prerror("RESET: XSCOM error %d reading RAS status"
+				" of 0x%x\n", rc, cpu->pir);
+			return rc;
+		}
+		if ((val & P9_THREAD_QUIESCED(thread_id)) ==
+		    P9_THREAD_QUIESCED(thread_id))
+			return 0;
+		time_wait_us(1);
+	} while (mftb() < poll_target);
+
+	prerror("RESET: Timeout stopping 0x%x, RAS status 0x%016llx\n",
+		cpu->pir, val);
+	return OPAL_HARDWARE;
+}
+
+static int p9_sreset_thread(struct cpu_thread *cpu)
+{
+	uint32_t chip_id = pir_to_chip_id(cpu->pir);
+	uint32_t core_id = pir_to_core_id(cpu->pir);
+	uint32_t thread_id = pir_to_thread_id(cpu->pir);
+	int rc;
+
+	rc = xscom_write(chip_id, XSCOM_ADDR_P9_EC(core_id,
+						   P9_EC_DIRECT_CONTROLS),
+			 P9_THREAD_SRESET(thread_id));
+	if (rc)
+		prerror("RESET: XSCOM error %d resetting 0x%x\n", rc, cpu->pir);
+	return rc;
+}
+
+/*
+ * Unlike P8, we don't need another thread to reset us: the caller
+ * branches to the reset vector itself once everybody else is on
+ * their way.
+ */
+static bool fast_reset_p9(void)
+{
+	struct cpu_thread *cpu;
+	uint64_t stamp;
+
+	prlog(PR_DEBUG, "RESET: Resetting from cpu: 0x%x (core 0x%x)\n",
+	      this_cpu()->pir, pir_to_core_id(this_cpu()->pir));
+
+	/* Assert special wakup on all cores. Only on operational cores. */
+	stamp = mftb();
+	for_each_cpu(cpu) {
+		/* GARDed CPUs are marked unavailable. Skip them.  */
+		if (cpu->state == cpu_state_unavailable)
+			continue;
+
+		if (cpu->primary == cpu)
+			if (p9_assert_special_wakeup(cpu))
+				return false;
+	}
+
+	/* Then wait for them all, they wake up in parallel */
+	for_each_cpu(cpu) {
+		if (cpu->state == cpu_state_unavailable)
+			continue;
+
+		if (cpu->primary == cpu)
+			if (p9_wait_special_wakeup(cpu, stamp))
+				return false;
+	}
+
+	prlog(PR_DEBUG, "RESET: Stopping the world...\n");
+
+	for_each_cpu(cpu) {
+		/* GARDed CPUs are marked unavailable. Skip them.  */
+		if (cpu->state == cpu_state_unavailable)
+			continue;
+
+		if (cpu != this_cpu())
+			if (p9_stop_thread(cpu))
+				return false;
+
+		/* Make our reset vector jump to fast_reboot_entry */
+		cpu->save_r1 = 0;
+	}
+
+	/* Restore skiboot vectors  */
+	copy_exception_vectors();
+	setup_reset_vector();
+
+	prlog(PR_DEBUG, "RESET: Resetting all threads but one...\n");
+
+	for_each_cpu(cpu) {
+		/* GARDed CPUs are marked unavailable. Skip them.  */
+		if (cpu->state == cpu_state_unavailable)
+			continue;
+
+		if (cpu != this_cpu())
+			if (p9_sreset_thread(cpu))
+				return false;
+	}
+
+	return true;
+}
+
+/*
+ * Wait for all other CPUs to leave OPAL. From now on, opal_entry turns
+ * new calls away with OPAL_BUSY, so this doesn't take long unless a
+ * CPU is stuck in OPAL, in which case we'd rather do a full reboot
+ * than reset it with locks held.
+ */
+static bool fast_reboot_wait_opal_exit(void)
+{
+	struct cpu_thread *cpu;
+	uint64_t end = mftb() + msecs_to_tb(FAST_REBOOT_OPAL_EXIT_TIMEOUT);
+
+	for_each_cpu(cpu) {
+		if (cpu == this_cpu())
+			continue;
+
+		while (cpu->in_opal_call) {
+			if (tb_compare(mftb(), end) == TB_AAFTERB) {
+				prerror("RESET: CPU 0x%04x still in OPAL (token"
+					" %lld)\n", cpu->pir,
+					cpu->current_token);
+				return false;
+			}
+			smt_lowest();
+			sync();
+		}
+		smt_medium();
+	}
+	return true;
+}
+
 extern void *fdt;
 extern struct lock capi_lock;
 
@@ -313,7 +564,7 @@ void fast_reboot(void)
 	bool success;
 	static int fast_reboot_count = 0;
 
-	if (proc_gen != proc_gen_p8) {
+	if (proc_gen != proc_gen_p8 && proc_gen != proc_gen_p9) {
 		prlog(PR_DEBUG,
 		      "RESET: Fast reboot not available on this CPU\n");
 		return;
@@ -334,31 +585,37 @@ void fast_reboot(void)
 	unlock(&fast_reboot_disabled_lock);
 
 	prlog(PR_NOTICE, "RESET: Initiating fast reboot %d...\n", ++fast_reboot_count);
-	free(fdt);
+	fr_tb.start = mftb();
 
-	/* XXX We need a way to ensure that no other CPU is in skiboot
-	 * holding locks (via the OPAL APIs) and if they are, we need
-	 * for them to get out. Hopefully that isn't happening, but...
-	 *
-	 * To fix this properly, we want to keep track of OPAL entry/exit
-	 * on all CPUs.
-	 */
+	/* Make sure no other CPU is in OPAL, possibly holding locks */
 	reboot_in_progress = 1;
-	time_wait_ms(200);
+	sync();
+	if (!fast_reboot_wait_opal_exit()) {
+		prlog(PR_NOTICE, "RESET: Falling back to a full reboot\n");
+		reboot_in_progress = 0;
+		return;
+	}
+	fr_tb.opal_exit = mftb();
+
+	free(fdt);
 
 	/* Lock so the new guys coming don't reset us */
 	lock(&reset_lock);
 
 	fast_boot_release = false;
 
-	success = fast_reset_p8();
+	if (proc_gen == proc_gen_p9)
+		success = fast_reset_p9();
+	else
+		success = fast_reset_p8();
+	fr_tb.reset = mftb();
 
 	/* Unlock, at this point we go away */
 	unlock(&reset_lock);
 
 	if (success) {
-		if (!next_cpu(first_cpu()))
-			/* Only 1 CPU, so fake reset ourselves */
+		if (proc_gen == proc_gen_p9 || !next_cpu(first_cpu()))
+			/* Nobody is going to reset us, do it ourselves */
 			asm volatile("ba 0x100 " : : : );
 		/* Don't return */
 		for (;;)
@@ -458,7 +715,15 @@ void __noreturn fast_reboot_entry(void)
 	struct cpu_thread *cpu;
 
 	prlog(PR_DEBUG, "RESET: CPU 0x%04x reset in\n", this_cpu()->pir);
-	time_wait_ms(100);
+
+	/* Whatever OPAL call we were in, we aren't coming back from it */
+	this_cpu()->in_opal_call = 0;
+
+	/* On P8, give the others time to be reset before we fix up the
+	 * last man standing
+	 */
+	if (proc_gen == proc_gen_p8)
+		time_wait_ms(100);
 
 	lock(&reset_lock);
 	if (last_man_standing && next_cpu(first_cpu())) {
@@ -469,15 +734,17 @@ void __noreturn fast_reboot_entry(void)
 	last_man_standing = NULL;
 	unlock(&reset_lock);
 
-	/* We reset our ICP first ! Otherwise we might get stray interrupts
-	 * when unsplitting
-	 */
-	reset_cpu_icp();
+	if (proc_gen == proc_gen_p8) {
+		/* We reset our ICP first ! Otherwise we might get stray
+		 * interrupts when unsplitting
+		 */
+		reset_cpu_icp();
 
-	/* If we are split, we need to unsplit. Since that can send us
-	 * to NAP, which will come back via reset, we do it now
-	 */
-	check_split_core();
+		/* If we are split, we need to unsplit. Since that can send us
+		 * to NAP, which will come back via reset, we do it now
+		 */
+		check_split_core();
+	}
 
 	/* Are we the original boot CPU ? If not, we spin waiting
 	 * for a relase signal from CPU 1, then we clean ourselves
@@ -515,6 +782,8 @@ void __noreturn fast_reboot_entry(void)
 		smt_medium();
 	}
 
+	fr_tb.callin = mftb();
+
 	prlog(PR_INFO, "RESET: Releasing secondaries...\n");
 
 	/* Release everybody */
@@ -550,6 +819,10 @@ void __noreturn fast_reboot_entry(void)
 
 	prlog(PR_INFO, "RESET: All done, cleaning up...\n");
 
+	/* Profile the rest of this boot on its own */
+	bootprof_reset();
+	bootprof_phase("fast_reboot_cleanup");
+
 	/* Clear release flag for next time */
 	fast_boot_release = false;
 	reboot_in_progress = 0;
@@ -563,6 +836,12 @@ void __noreturn fast_reboot_entry(void)
 	/* Let the CPU layer do some last minute global cleanups */
 	cpu_fast_reboot_complete();
 
+	/* Put XIVE back in emulation mode with everything masked */
+	if (proc_gen == proc_gen_p9)
+		xive_reset();
+
+	fr_tb.cleanup = mftb();
+
 	/* We can now do NAP mode */
 	cpu_set_pm_enable(true);
 
@@ -576,7 +855,18 @@ void __noreturn fast_reboot_entry(void)
 	psi_irq_reset();
 
 	/* Remove all PCI devices */
+	bootprof_phase("pci_reset");
 	pci_reset();
+	fr_tb.pci = mftb();
+
+	prlog(PR_NOTICE, "RESET: Fast reboot took %lu ms: OPAL exit %lu,"
+	      " CPU reset %lu, callin %lu, cleanup %lu, PCI %lu\n",
+	      tb_to_msecs(fr_tb.pci - fr_tb.start),
+	      tb_to_msecs(fr_tb.opal_exit - fr_tb.start),
+	      tb_to_msecs(fr_tb.reset - fr_tb.opal_exit),
+	      tb_to_msecs(fr_tb.callin - fr_tb.reset),
+	      tb_to_msecs(fr_tb.cleanup - fr_tb.callin),
+	      tb_to_msecs(fr_tb.pci - fr_tb.cleanup));
 
 	ipmi_set_fw_progress_sensor(IPMI_FW_PCI_INIT);
 
@@ -0,0 +1,54 @@
+/* Copyright 2013-2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <skiboot.h>
+#include <libflash/blocklevel.h>
+#include <decompress.h>
+
+/*
+ * Load an XZ compressed partition. The compressed data is read into the
+ * end of the caller's buffer and decompressed in one go into the front
+ * of it. That way the output buffer is the decoder's dictionary, so
+ * nothing comes from the heap whatever dictionary size the image was
+ * made with.
+ *
+ * len is the partition's (actual) size without ECC, which is usually
+ * more than the stream. Any erased flash after the stream is dropped so
+ * that xz_decompress() can find the index and split up the blocks.
+ */
+int flash_load_xz(struct blocklevel_device *bl, uint64_t pos, uint64_t len,
+		  void *buf, size_t bufsz, size_t *out_len)
+{
+	uint8_t *in;
+	int rc;
+
+	if (len >= bufsz) {
+		prerror("FLASH: no room to decompress 0x%llx bytes\n",
+			(unsigned long long)len);
+		return -1;
+	}
+	in = buf + ALIGN_DOWN(bufsz - len, 8);
+
+	rc = blocklevel_read(bl, pos, in, len);
+	if (rc)
+		return rc;
+
+	/* A stream always ends in "YZ" or zero padding, never 0xff */
+	while (len && in[len - 1] == 0xff)
+		len--;
+
+	return xz_decompress(buf, in - (uint8_t *)buf, in, len, out_len);
+}
@@ -27,6 +27,7 @@
 #include <libstb/stb.h>
 #include <libstb/container.h>
 #include <elf.h>
+#include <decompress.h>
 
 struct flash {
 	struct list_node	list;
@@ -451,6 +452,38 @@ static size_t sizeof_elf_from_hdr(void *buf)
 	return sz;
 }
 
+/*
+ * Read the part of a resource that tb_measure() will hash, a chunk at a
+ * time, hashing each chunk while it's still in the cache. Chunks are a
+ * multiple of the ECC word so the raw position stays in step.
+ */
+#define FLASH_HASH_CHUNK	0x40000
+
+static int flash_read_hashed(struct blocklevel_device *bl, uint64_t pos,
+			     void *buf, uint64_t len, bool ecc,
+			     struct stb_hash *hash)
+{
+	uint64_t chunk;
+	int rc;
+
+	if (!hash->active)
+		return blocklevel_read(bl, pos, buf, len);
+
+	while (len) {
+		chunk = MIN(len, FLASH_HASH_CHUNK);
+		rc = blocklevel_read(bl, pos, buf, chunk);
+		if (rc)
+			return rc;
+		stb_hash_update(hash, buf, chunk);
+		pos += ecc ? ecc_buffer_size(chunk) : chunk;
+		buf += chunk;
+		len -= chunk;
+	}
+	stb_hash_finish(hash);
+
+	return 0;
+}
+
 /*
  * load a resource from FLASH
  * buf and len shouldn't account for ECC even if partition is ECCed.
@@ -473,11 +506,15 @@ static int flash_load_resource(enum resource_id id, uint32_t subid,
 	bool status = false;
 	bool ecc;
 	bool part_signed = false;
+	bool xz;
 	void *bufp = buf;
+	void *tmp;
+	size_t xz_len;
 	size_t bufsz = *len;
 	int ffs_part_num, ffs_part_start, ffs_part_size;
 	int content_size = 0;
 	int offset = 0;
+	struct stb_hash hash;
 
 	lock(&flash_lock);
 
@@ -540,6 +577,14 @@ static int flash_load_resource(enum resource_id id, uint32_t subid,
 	prlog(PR_DEBUG,"FLASH: %s partition %s ECC\n",
 	      name, ecc  ? "has" : "doesn't have");
 
+	xz = has_xz(ffs_entry_get(ffs, ffs_part_num));
+	if (xz && subid != RESOURCE_SUBID_NONE) {
+		prerror("FLASH: %s partition is compressed, can't have "
+			"subpartitions\n", name);
+		rc = OPAL_UNSUPPORTED;
+		goto out_free_ffs;
+	}
+
 	if ((ecc ? ecc_buffer_size_minus_ecc(ffs_part_size) : ffs_part_size) <
 	     SECURE_BOOT_HEADERS_SIZE) {
 		prerror("FLASH: secboot headers bigger than "
@@ -557,6 +602,7 @@ static int flash_load_resource(enum resource_id id, uint32_t subid,
 	}
 
 	part_signed = stb_is_container(bufp, SECURE_BOOT_HEADERS_SIZE);
+	stb_hash_start(&hash, id);
 
 	prlog(PR_DEBUG, "FLASH: %s partition %s signed\n", name,
 	      part_signed ? "is" : "isn't");
@@ -581,8 +627,50 @@ static int flash_load_resource(enum resource_id id, uint32_t subid,
 		if (ecc)
 			ffs_part_start += ecc_size(SECURE_BOOT_HEADERS_SIZE);
 
-		rc = blocklevel_read(flash->bl, ffs_part_start, bufp,
-					  content_size);
+		if (xz) {
+			/*
+			 * The container signs the compressed payload, so
+			 * that's what we verify and measure. Stage it with a
+			 * copy of the header at the end of the buffer, then
+			 * decompress it into place behind the header.
+			 */
+			tmp = bufp + ALIGN_DOWN(bufsz - content_size, 8);
+			if (tmp - bufp < SECURE_BOOT_HEADERS_SIZE) {
+				prerror("FLASH: no room to decompress %s\n",
+					name);
+				rc = OPAL_RESOURCE;
+				goto out_free_ffs;
+			}
+			tmp -= SECURE_BOOT_HEADERS_SIZE;
+			memcpy(tmp, buf, SECURE_BOOT_HEADERS_SIZE);
+
+			rc = flash_read_hashed(flash->bl, ffs_part_start,
+					       tmp + SECURE_BOOT_HEADERS_SIZE,
+					       content_size, ecc, &hash);
+			if (rc) {
+				prerror("FLASH: failed to read content size %d"
+					" %s partition, rc %d\n",
+					content_size, name, rc);
+				goto out_free_ffs;
+			}
+			sb_verify(id, tmp, *len);
+			tb_measure_hashed(id, tmp, *len, &hash);
+
+			rc = xz_decompress(bufp, tmp - bufp,
+					   tmp + SECURE_BOOT_HEADERS_SIZE,
+					   content_size, &xz_len);
+			if (rc) {
+				prerror("FLASH: failed to decompress %s\n",
+					name);
+				rc = OPAL_RESOURCE;
+				goto out_free_ffs;
+			}
+			*len = SECURE_BOOT_HEADERS_SIZE + xz_len;
+			goto done_measured;
+		}
+
+		rc = flash_read_hashed(flash->bl, ffs_part_start, bufp,
+				       content_size, ecc, &hash);
 		if (rc) {
 			prerror("FLASH: failed to read content size %d"
 				" %s partition, rc %d\n",
@@ -602,6 +690,19 @@ static int flash_load_resource(enum resource_id id, uint32_t subid,
 		}
 		bufp += offset;
 		goto done_reading;
+	} else if (xz) {
+		rc = flash_load_xz(flash->bl, ffs_part_start,
+				   ecc ? ecc_buffer_size_minus_ecc(ffs_part_size)
+				       : ffs_part_size,
+				   buf, bufsz, len);
+		if (rc) {
+			prerror("FLASH: failed to load compressed %s partition,"
+				" rc %d\n", name, rc);
+			goto out_free_ffs;
+		}
+		stb_hash_update(&hash, buf, *len);
+		stb_hash_finish(&hash);
+		goto done_reading;
 	} else /* stb_signed */ {
 		/*
 		 * Back to the old way of doing things, no STB header.
@@ -620,8 +721,8 @@ static int flash_load_resource(enum resource_id id, uint32_t subid,
 			}
 			prlog(PR_DEBUG, "FLASH: computed %s size %u\n",
 			      name, content_size);
-			rc = blocklevel_read(flash->bl, ffs_part_start,
-						  buf, content_size);
+			rc = flash_read_hashed(flash->bl, ffs_part_start,
+					       buf, content_size, ecc, &hash);
 			if (rc) {
 				prerror("FLASH: failed to read content size %d"
 					" %s partition, rc %d\n",
@@ -651,8 +752,8 @@ static int flash_load_resource(enum resource_id id, uint32_t subid,
 		 * Afterwards, we memmove() things back into place for
 		 * the caller.
 		 */
-		rc = blocklevel_read(flash->bl, ffs_part_start,
-					  buf, ffs_part_size);
+		rc = flash_read_hashed(flash->bl, ffs_part_start,
+				       buf, ffs_part_size, ecc, &hash);
 
 		bufp += offset;
 	}
@@ -663,8 +764,9 @@ done_reading:
 	 * secure boot and trusted boot requirements
 	 */
 	sb_verify(id, buf, *len);
-	tb_measure(id, buf, *len);
+	tb_measure_hashed(id, buf, *len, &hash);
 
+done_measured:
 	/* Find subpartition */
 	if (subid != RESOURCE_SUBID_NONE) {
 		memmove(buf, bufp, content_size);
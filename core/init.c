@@ -42,6 +42,7 @@
 #include <libfdt/libfdt.h>
 #include <timer.h>
 #include <ipmi.h>
+#include <bt.h>
 #include <sensor.h>
 #include <xive.h>
 #include <nvram.h>
@@ -50,6 +51,9 @@
 #include <libstb/container.h>
 #include <phys-map.h>
 #include <imc.h>
+#include <errorlog.h>
+#include <timebase.h>
+#include <bootprof.h>
 
 enum proc_gen proc_gen;
 unsigned int pcie_max_link_speed;
@@ -483,6 +487,7 @@ void __noreturn load_and_boot_kernel(bool is_reboot)
 		platform.exit();
 
 	/* Load kernel LID */
+	bootprof_phase("load_kernel");
 	if (!load_kernel()) {
 		op_display(OP_FATAL, OP_MOD_INIT, 1);
 		abort();
@@ -492,6 +497,7 @@ void __noreturn load_and_boot_kernel(bool is_reboot)
 
 	ipmi_set_fw_progress_sensor(IPMI_FW_OS_BOOT);
 
+	bootprof_phase("fsp_wait");
 	if (!is_reboot) {
 		/* We wait for the nvram read to complete here so we can
 		 * grab stuff from there such as the kernel arguments
@@ -509,7 +515,9 @@ void __noreturn load_and_boot_kernel(bool is_reboot)
 	 * OCC takes few secs to boot.  Call this as late as
 	 * as possible to avoid delay.
 	 */
+	bootprof_phase("occ_pstates_init");
 	occ_pstates_init();
+	bootprof_phase("occ_sensors_init");
 	occ_sensors_init();
 
 	/* Use nvram bootargs over device tree */
@@ -524,6 +532,7 @@ void __noreturn load_and_boot_kernel(bool is_reboot)
 	op_display(OP_LOG, OP_MOD_INIT, 0x000B);
 
 	/* Create the device tree blob to boot OS. */
+	bootprof_phase("create_dtb");
 	fdt = create_dtb(dt_root, false);
 	if (!fdt) {
 		op_display(OP_FATAL, OP_MOD_INIT, 2);
@@ -532,6 +541,9 @@ void __noreturn load_and_boot_kernel(bool is_reboot)
 
 	op_display(OP_LOG, OP_MOD_INIT, 0x000C);
 
+	/* Last chance to record anything, the profile is now the OS's */
+	bootprof_finish();
+
 	/* Start the kernel */
 	if (!is_reboot)
 		op_panel_disable_src_echo();
@@ -835,6 +847,9 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 	 */
 	opal_table_init();
 
+	/* Start recording how long each step of the boot takes */
+	bootprof_reset();
+
 	/* Init the physical map table so we can start mapping things */
 	phys_map_init();
 
@@ -844,6 +859,8 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 	 *
 	 * Hack alert: When entering via the OPAL entry point, fdt
 	 * is set to -1, we record that and pass it to parse_hdat
+	 *
+	 * parse_hdat() records each of its steps as a boot profile phase.
 	 */
 
 	dt_root = dt_new_root("");
@@ -855,10 +872,12 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 		if (parse_hdat(false) < 0)
 			abort();
 	} else {
+		bootprof_phase("dt_expand");
 		dt_expand(fdt);
 	}
 
 	/* Now that we have a full devicetree, verify that we aren't on fire. */
+	bootprof_phase("sanity_checks");
 	per_thread_sanity_checks();
 
 	/*
@@ -873,8 +892,10 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 	 * We also initialize the FSI master at that point in case we need
 	 * to access chips via that path early on.
 	 */
+	bootprof_phase("init_chips");
 	init_chips();
 
+	bootprof_phase("xscom_init");
 	xscom_init();
 	mfsi_init();
 
@@ -891,6 +912,7 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 	 * so that the platform probing code can access an external
 	 * BMC if needed.
 	 */
+	bootprof_phase("lpc_init");
 	lpc_init();
 
 	/*
@@ -900,6 +922,7 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 	 * allocations outside of our heap, such as chip local allocs,
 	 * otherwise we might clobber those data.
 	 */
+	bootprof_phase("mem_region_init");
 	mem_region_init();
 
 	/* Reserve HOMER and OCC area */
@@ -914,15 +937,18 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 	 *
 	 * Note: Timebases still not synchronized.
 	 */
+	bootprof_phase("probe_platform");
 	probe_platform();
 
 	/* Initialize the rest of the cpu thread structs */
+	bootprof_phase("init_all_cpus");
 	init_all_cpus();
 
 	/* Allocate our split trace buffers now. Depends add_opal_node() */
 	init_trace_buffers();
 
 	/* On P7/P8, get the ICPs and make sure they are in a sane state */
+	bootprof_phase("init_interrupts");
 	init_interrupts();
 
 	/* On P9, initialize XIVE */
@@ -941,6 +967,7 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 	lpc_init_interrupts();
 
 	/* Call in secondary CPUs */
+	bootprof_phase("cpu_bringup");
 	cpu_bringup();
 
 	/* We can now overwrite the 0x100 vector as we are no longer being
@@ -954,11 +981,16 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 	/*
 	 * Synchronize time bases. Thi resets all the TB values to a small
 	 * value (so they appear to go backward at this point), and synchronize
-	 * all core timebases to the global ChipTOD network
+	 * all core timebases to the global ChipTOD network.
+	 *
+	 * chiptod tells the boot profile when the boot CPU's timebase
+	 * jumps, so the phase still covers the rest of the sync.
 	 */
+	bootprof_phase("chiptod_init");
 	chiptod_init();
 
 	/* Initialize i2c */
+	bootprof_phase("platform_init");
 	p8_i2c_init();
 
 	/* Register routine to dispatch and read sensors */
@@ -980,6 +1012,7 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 		platform.init();
 
 	/* Read in NVRAM and set it up */
+	bootprof_phase("nvram_init");
 	nvram_init();
 
 	/* preload the IMC catalog dtb */
@@ -989,23 +1022,33 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 	console_log_level();
 
 	/* Secure/Trusted Boot init. We look for /ibm,secureboot in DT */
+	bootprof_phase("stb_init");
 	stb_init();
 
 	/* Install the OPAL Console handlers */
 	init_opal_console();
 
 	/* Init SLW related stuff, including fastsleep */
+	bootprof_phase("slw_init");
 	slw_init();
 
 	op_display(OP_LOG, OP_MOD_INIT, 0x0002);
 
 	pci_nvram_init();
+	xscom_nvram_init();
+	bt_nvram_init();
+
+	/* Record memory-only log messages as binary traces */
+	if (nvram_query_eq("log-mode", "binary"))
+		debug_descriptor.trace_mask |= 1ul << TRACE_PRLOG;
 
+	bootprof_phase("preload");
 	preload_io_vpd();
 	preload_capp_ucode();
 	start_preload_kernel();
 
 	/* Virtual Accelerator Switchboard */
+	bootprof_phase("accel_init");
 	vas_init();
 
 	/* NX init */
@@ -1015,6 +1058,7 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 	imc_init();
 
 	/* Probe IO hubs */
+	bootprof_phase("probe_phbs");
 	probe_p7ioc();
 
 	/* Probe PHB3 on P8 */
@@ -1028,6 +1072,7 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 	probe_npu2();
 
 	/* Initialize PCI */
+	bootprof_phase("pci_init_slots");
 	pci_init_slots();
 
 	/* Add OPAL timer related properties */
@@ -1046,6 +1091,7 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 	 */
 
 	/* Create the LPC bus interrupt-map on P9 */
+	bootprof_phase("finalize");
 	lpc_finalize_interrupts();
 
 	/* Add the list of interrupts going to OPAL */
@@ -1062,6 +1108,11 @@ void __noreturn __nomcount main_cpu_entry(const void *fdt)
 	/* On P9, switch to radix mode by default */
 	cpu_set_radix_mode();
 
+	xscom_dump_stats();
+	fsp_dump_stats();
+	p8_i2c_dump_stats();
+	elog_dump_stats();
+
 	load_and_boot_kernel(false);
 }
 
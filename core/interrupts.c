@@ -35,6 +35,84 @@ static LIST_HEAD(irq_sources);
 static LIST_HEAD(irq_sources2);
 static struct lock irq_lock = LOCK_UNLOCKED;
 
+/*
+ * Lookup tables for irq_find_source()
+ *
+ * For each of the two source lists we maintain an array of the
+ * sources sorted by start number. It is rebuilt under irq_lock
+ * whenever a source is added or removed and published with a
+ * single pointer store, so the lookup itself is a lock-free
+ * binary search.
+ *
+ * A reader may still be walking the previous table when it gets
+ * replaced, so we keep one generation around and only free a table
+ * once it has been superseded twice. Sources are (un)registered at
+ * boot and on hotplug only, so this is plenty.
+ */
+struct irq_table {
+	unsigned int		count;
+	struct irq_source	*sources[];
+};
+
+static struct irq_table *irq_tables[2];
+static struct irq_table *irq_tables_prev[2];
+
+static void irq_rebuild_table(struct list_head *list, unsigned int idx)
+{
+	struct irq_table *t;
+	struct irq_source *is;
+	unsigned int i, n = 0;
+
+	assert(lock_held_by_me(&irq_lock));
+
+	list_for_each(list, is, link)
+		n++;
+	t = malloc(sizeof(struct irq_table) + n * sizeof(struct irq_source *));
+	assert(t);
+
+	/* Insertion sort, lists are short and this is rare */
+	t->count = 0;
+	list_for_each(list, is, link) {
+		for (i = t->count; i > 0; i--) {
+			if (t->sources[i - 1]->start < is->start)
+				break;
+			t->sources[i] = t->sources[i - 1];
+		}
+		t->sources[i] = is;
+		t->count++;
+	}
+
+	/* Make sure the content is visible before the pointer */
+	lwsync();
+	free(irq_tables_prev[idx]);
+	irq_tables_prev[idx] = irq_tables[idx];
+	irq_tables[idx] = t;
+}
+
+static struct irq_source *irq_table_lookup(struct irq_table *t, uint32_t isn)
+{
+	struct irq_source *is;
+	unsigned int lo = 0, hi, mid;
+
+	if (!t)
+		return NULL;
+
+	/* Find the last source starting at or below isn */
+	hi = t->count;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (t->sources[mid]->start <= isn)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (!lo)
+		return NULL;
+	is = t->sources[lo - 1];
+
+	return isn < is->end ? is : NULL;
+}
+
 void __register_irq_source(struct irq_source *is, bool secondary)
 {
 	struct irq_source *is1;
@@ -55,6 +133,7 @@ void __register_irq_source(struct irq_source *is, bool secondary)
 		}
 	}
 	list_add_tail(list, &is->link);
+	irq_rebuild_table(list, secondary ? 1 : 0);
 	unlock(&irq_lock);
 }
 
@@ -89,6 +168,7 @@ void unregister_irq_source(uint32_t start, uint32_t count)
 				assert(0);
 			}
 			list_del(&is->link);
+			irq_rebuild_table(&irq_sources, 0);
 			unlock(&irq_lock);
 			/* XXX Add synchronize / RCU */
 			free(is);
@@ -105,25 +185,15 @@ struct irq_source *irq_find_source(uint32_t isn)
 {
 	struct irq_source *is;
 
-	lock(&irq_lock);
 	/*
-	 * XXX This really needs some kind of caching !
+	 * No lock here, see the comment above irq_rebuild_table().
+	 * Primary sources take precedence over secondary ones.
 	 */
-	list_for_each(&irq_sources, is, link) {
-		if (isn >= is->start && isn < is->end) {
-			unlock(&irq_lock);
-			return is;
-		}
-	}
-	list_for_each(&irq_sources2, is, link) {
-		if (isn >= is->start && isn < is->end) {
-			unlock(&irq_lock);
-			return is;
-		}
-	}
-	unlock(&irq_lock);
+	is = irq_table_lookup(irq_tables[0], isn);
+	if (!is)
+		is = irq_table_lookup(irq_tables[1], isn);
 
-	return NULL;
+	return is;
 }
 
 void irq_for_each_source(void (*cb)(struct irq_source *, void *), void *data)
@@ -1204,6 +1204,26 @@ static void mem_region_add_dt_reserved_node(struct dt_node *parent,
 	free(name);
 }
 
+/*
+ * Find or create /reserved-memory. It's normally made by
+ * mem_region_add_dt_reserved(), but code that runs before then can use
+ * this to add nodes of its own to it.
+ */
+struct dt_node *mem_region_dt_reserved_root(void)
+{
+	struct dt_node *node;
+
+	node = dt_find_by_path(dt_root, "reserved-memory");
+	if (!node) {
+		node = dt_new(dt_root, "reserved-memory");
+		assert(node);
+		dt_add_property_cells(node, "#address-cells", 2);
+		dt_add_property_cells(node, "#size-cells", 2);
+		dt_add_property(node, "ranges", NULL, 0);
+	}
+	return node;
+}
+
 void mem_region_add_dt_reserved(void)
 {
 	int names_len, ranges_len, len;
@@ -1224,13 +1244,7 @@ void mem_region_add_dt_reserved(void)
 	mem_regions_finalised = true;
 
 	/* establish top-level reservation node */
-	node = dt_find_by_path(dt_root, "reserved-memory");
-	if (!node) {
-		node = dt_new(dt_root, "reserved-memory");
-		dt_add_property_cells(node, "#address-cells", 2);
-		dt_add_property_cells(node, "#size-cells", 2);
-		dt_add_property(node, "ranges", NULL, 0);
-	}
+	node = mem_region_dt_reserved_root();
 
 	/* First pass: calculate length of property data */
 	list_for_each(&regions, region, list) {
@@ -31,6 +31,7 @@
 #include <timer.h>
 #include <elf-abi.h>
 #include <errorlog.h>
+#include <bootprof.h>
 
 /* Pending events to signal via opal_poll_events */
 uint64_t opal_pending_events;
@@ -151,6 +152,7 @@ static void add_opal_firmware_exports_node(struct dt_node *node)
 	dt_add_property_u64s(exports, "symbol_map", sym_start, sym_size);
 	dt_add_property_u64s(exports, "hdat_map", SPIRA_HEAP_BASE,
 				SPIRA_HEAP_SIZE);
+	bootprof_export(exports);
 }
 
 static void add_opal_firmware_node(void)
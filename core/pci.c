@@ -1646,48 +1646,33 @@ static void __pci_reset(struct list_head *list)
 	}
 }
 
-void pci_reset(void)
+static bool pci_reset_failed;
+
+static void pci_reset_one(void *data)
 {
-	unsigned int i;
+	struct phb *phb = data;
 	struct pci_slot *slot;
 	int64_t rc;
 
-	prlog(PR_NOTICE, "PCI: Clearing all devices...\n");
-
-	/* XXX Do those in parallel (at least the power up
-	 * state machine could be done in parallel)
-	 */
-	for (i = 0; i < ARRAY_SIZE(phbs); i++) {
-		struct phb *phb = phbs[i];
-		if (!phb)
-			continue;
-		__pci_reset(&phb->devices);
-
-		slot = phb->slot;
-		if (!slot || !slot->ops.creset) {
-			PCINOTICE(phb, 0, "Can't do complete reset\n");
-		} else {
-			rc = slot->ops.creset(slot);
-			while (rc > 0) {
-				time_wait(rc);
-				rc = slot->ops.run_sm(slot);
-			}
-			if (rc < 0) {
-				PCIERR(phb, 0, "Complete reset failed, aborting"
-				               "fast reboot (rc=%lld)\n", rc);
-				if (platform.cec_reboot)
-					platform.cec_reboot();
-				while (true) {}
-			}
+	slot = phb->slot;
+	if (!slot || !slot->ops.creset) {
+		PCINOTICE(phb, 0, "Can't do complete reset\n");
+	} else {
+		rc = slot->ops.creset(slot);
+		while (rc > 0) {
+			time_wait(rc);
+			rc = slot->ops.run_sm(slot);
+		}
+		if (rc < 0) {
+			PCIERR(phb, 0, "Complete reset failed, aborting"
+			               "fast reboot (rc=%lld)\n", rc);
+			pci_reset_failed = true;
+			return;
 		}
-
-		if (phb->ops->ioda_reset)
-			phb->ops->ioda_reset(phb, true);
 	}
 
-	/* Re-Initialize all discovered PCI slots */
-	pci_init_slots();
-
+	if (phb->ops->ioda_reset)
+		phb->ops->ioda_reset(phb, true);
 }
 
 static void pci_do_jobs(void (*fn)(void *))
@@ -1722,6 +1707,35 @@ static void pci_do_jobs(void (*fn)(void *))
 	free(jobs);
 }
 
+void pci_reset(void)
+{
+	unsigned int i;
+	uint64_t start = mftb();
+
+	prlog(PR_NOTICE, "PCI: Clearing all devices...\n");
+
+	/* The device nodes are in the device tree, so free them here */
+	for (i = 0; i < ARRAY_SIZE(phbs); i++) {
+		if (phbs[i])
+			__pci_reset(&phbs[i]->devices);
+	}
+
+	/* The PHBs reset independently, so do them all at once */
+	pci_reset_failed = false;
+	pci_do_jobs(pci_reset_one);
+	if (pci_reset_failed) {
+		if (platform.cec_reboot)
+			platform.cec_reboot();
+		while (true) {}
+	}
+	prlog(PR_INFO, "PCI: Complete reset of all PHBs took %lu ms\n",
+	      tb_to_msecs(mftb() - start));
+
+	/* Re-Initialize all discovered PCI slots */
+	pci_init_slots();
+
+}
+
 void pci_init_slots(void)
 {
 	unsigned int i;
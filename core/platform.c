@@ -41,6 +41,7 @@ static int64_t opal_cec_power_down(uint64_t request)
 {
 	prlog(PR_NOTICE, "OPAL: Shutdown request type 0x%llx...\n", request);
 
+	elog_flush_pending();
 	console_complete_flush();
 
 	if (platform.cec_power_down)
@@ -54,6 +55,7 @@ static int64_t opal_cec_reboot(void)
 {
 	prlog(PR_NOTICE, "OPAL: Reboot request...\n");
 
+	elog_flush_pending();
 	console_complete_flush();
 
 	/* Try a fast reset first, if enabled */
@@ -91,6 +93,7 @@ static int64_t opal_cec_reboot2(uint32_t reboot_type, char *diag)
 			prerror("OPAL: failed to log an error\n");
 		}
 		disable_fast_reboot("Reboot due to Platform Error");
+		elog_flush_pending();
 		return xscom_trigger_xstop();
 	case OPAL_REBOOT_FULL_IPL:
 		disable_fast_reboot("full IPL reboot requested");
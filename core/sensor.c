@@ -41,6 +41,45 @@ static int64_t opal_sensor_read(uint32_t sensor_hndl, int token,
 	return OPAL_UNSUPPORTED;
 }
 
+static int64_t opal_sensor_read_batch(struct opal_sensor_read *reqs,
+				      uint64_t count)
+{
+	uint32_t handle, data;
+	int64_t rc, ret = OPAL_SUCCESS;
+	uint64_t i;
+
+	if (!opal_addr_valid(reqs) || !count ||
+	    count > OPAL_SENSOR_READ_BATCH_MAX)
+		return OPAL_PARAMETER;
+
+	/* OCC sensors are read together, a snapshot per OCC */
+	occ_sensor_read_batch(reqs, count);
+
+	for (i = 0; i < count; i++) {
+		handle = be32_to_cpu(reqs[i].handle);
+		switch (sensor_get_family(handle)) {
+		case SENSOR_OCC:
+			rc = (int32_t)be32_to_cpu(reqs[i].rc);
+			break;
+		case SENSOR_DTS:
+			rc = dts_sensor_read(handle, &data);
+			if (!rc)
+				reqs[i].data = cpu_to_be32(data);
+			reqs[i].rc = cpu_to_be32(rc);
+			break;
+		default:
+			/* These can need an async request to the FSP */
+			rc = OPAL_UNSUPPORTED;
+			reqs[i].rc = cpu_to_be32(rc);
+			break;
+		}
+		if (rc)
+			ret = OPAL_PARTIAL;
+	}
+
+	return ret;
+}
+
 static int opal_sensor_group_clear(u32 group_hndl, int token)
 {
 	switch (sensor_get_family(group_hndl)) {
@@ -63,4 +102,5 @@ void sensor_init(void)
 	/* Register OPAL interface */
 	opal_register(OPAL_SENSOR_READ, opal_sensor_read, 3);
 	opal_register(OPAL_SENSOR_GROUP_CLEAR, opal_sensor_group_clear, 2);
+	opal_register(OPAL_SENSOR_READ_BATCH, opal_sensor_read_batch, 2);
 }
@@ -0,0 +1,131 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define __TEST__
+#define __PROCESSOR_H
+static inline void lwsync(void) { }
+
+#include <skiboot.h>
+#include <lock.h>
+
+static uint64_t stamp;
+#define mftb()	(stamp)
+
+unsigned long tb_hz = 512000000;
+
+static int lock_count;
+
+void lock(struct lock *l)
+{
+	(void)l;
+	assert(!lock_count++);
+}
+
+void unlock(struct lock *l)
+{
+	(void)l;
+	assert(lock_count--);
+}
+
+#undef pr_fmt
+#include "../bootprof.c"
+
+static struct bootprof_entry *entry(int i)
+{
+	assert(i < (int)be32_to_cpu(bootprof.hdr.nr_entries));
+	return &bootprof.entries[i];
+}
+
+int main(void)
+{
+	struct bootprof_entry *e;
+	int i;
+
+	bootprof_reset();
+	assert(be32_to_cpu(bootprof.hdr.magic) == BOOTPROF_MAGIC);
+	assert(be16_to_cpu(bootprof.hdr.entry_size) == sizeof(*e));
+	assert(be64_to_cpu(bootprof.hdr.tb_hz) == tb_hz);
+
+	/* Phases end when the next one starts */
+	stamp = 100;
+	bootprof_phase("one");
+	stamp = 150;
+	bootprof_job("job", 120);
+	stamp = 200;
+	bootprof_phase("two");
+	e = entry(0);
+	assert(!strcmp(e->name, "one") && e->type == BOOTPROF_PHASE);
+	assert(be64_to_cpu(e->start) == 100 && be64_to_cpu(e->end) == 200);
+	e = entry(1);
+	assert(!strcmp(e->name, "job") && e->type == BOOTPROF_JOB);
+	assert(be64_to_cpu(e->start) == 120 && be64_to_cpu(e->end) == 150);
+	assert(!entry(2)->end);
+
+	/*
+	 * The timebase goes back to 10 at 250, we carry on from 250.
+	 * A job that runs across the reset, like the chiptod sync
+	 * ones, isn't recorded.
+	 */
+	stamp = 250;
+	bootprof_tb_reset_begin();
+	stamp = 10;
+	bootprof_job("chiptod", 240);
+	bootprof_tb_reset_end();
+	assert(be32_to_cpu(bootprof.hdr.nr_entries) == 3);
+	stamp = 60;
+	bootprof_job("job", 20);
+	assert(be64_to_cpu(entry(3)->start) == 260);
+	assert(be64_to_cpu(entry(3)->end) == 300);
+
+	/* Nor is one that started before it and only just finished */
+	bootprof_job("job", 240);
+	assert(be32_to_cpu(bootprof.hdr.nr_entries) == 4);
+
+	/* A second end, as from a sync error path, leaves the times alone */
+	stamp = 80;
+	bootprof_tb_reset_end();
+	stamp = 60;
+
+	/* Names are cut short rather than overflowing */
+	bootprof_phase("a_phase_with_a_very_long_name_indeed");
+	assert(strlen(entry(4)->name) == BOOTPROF_NAME_LEN - 1);
+	assert(be64_to_cpu(entry(2)->end) == 300);
+
+	/* Nothing gets in once the kernel has it */
+	stamp = 160;
+	bootprof_finish();
+	assert(be64_to_cpu(entry(4)->end) == 400);
+	bootprof_phase("late");
+	bootprof_job("late", 160);
+	assert(be32_to_cpu(bootprof.hdr.nr_entries) == 5);
+
+	/* Running out of room is counted */
+	bootprof_reset();
+	assert(!bootprof.hdr.nr_entries);
+	stamp = 2 * BOOTPROF_MAX_ENTRIES;
+	for (i = 0; i < BOOTPROF_MAX_ENTRIES + 5; i++)
+		bootprof_job("job", i);
+	assert(be32_to_cpu(bootprof.hdr.nr_entries) == BOOTPROF_MAX_ENTRIES);
+	assert(be32_to_cpu(bootprof.hdr.dropped) == 5);
+
+	assert(!lock_count);
+	return 0;
+}
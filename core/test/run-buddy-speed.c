@@ -0,0 +1,104 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+static void *zalloc(size_t size)
+{
+        return calloc(size, 1);
+}
+
+#include "../buddy.c"
+#include "../bitmap.c"
+
+/* Same size as the XIVE VP allocator */
+#define BUDDY_ORDER	19
+
+/* Mimic KVM starting and stopping lots of guests */
+#define NUM_ALLOCS	(1u << 16)
+#define NUM_ROUNDS	8
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int main(void)
+{
+	struct buddy *b;
+	unsigned int i, r, order;
+	uint64_t start, ops = 0;
+	int *a;
+
+	a = calloc(NUM_ALLOCS, sizeof(int));
+	assert(a);
+	b = buddy_create(BUDDY_ORDER);
+	assert(b);
+
+	/* Like XIVE, the HW thread VPs are reserved */
+	assert(buddy_reserve(b, 0x800, 11));
+
+	start = now_ns();
+	for (r = 0; r < NUM_ROUNDS; r++) {
+		/* Fill up with a mix of small orders */
+		for (i = 0; i < NUM_ALLOCS; i++) {
+			order = (i & 3) ? 1 : 2;
+			a[i] = buddy_alloc(b, order);
+			assert(a[i] >= 0);
+			assert((a[i] & ((1 << order) - 1)) == 0);
+			assert(a[i] < 0x800 || a[i] >= 0x1000);
+			ops++;
+		}
+
+		/* Free every other one and allocate them again */
+		for (i = 0; i < NUM_ALLOCS; i += 2) {
+			order = (i & 3) ? 1 : 2;
+			buddy_free(b, a[i], order);
+			ops++;
+		}
+		for (i = 0; i < NUM_ALLOCS; i += 2) {
+			order = (i & 3) ? 1 : 2;
+			a[i] = buddy_alloc(b, order);
+			assert(a[i] >= 0);
+			ops++;
+		}
+
+		/* And release everything */
+		for (i = 0; i < NUM_ALLOCS; i++) {
+			order = (i & 3) ? 1 : 2;
+			buddy_free(b, a[i], order);
+			ops++;
+		}
+	}
+	printf("buddy: %llu ops in %llu us\n", (unsigned long long)ops,
+	       (unsigned long long)(now_ns() - start) / 1000);
+
+	/* Everything must have coalesced back, bar the reservation */
+	buddy_free(b, 0x800, 11);
+	for (i = 2; i < buddy_map_size(b); i++)
+		assert(bitmap_tst_bit(b->map, i));
+	assert(!bitmap_tst_bit(b->map, 1));
+
+	buddy_destroy(b);
+	free(a);
+	return 0;
+}
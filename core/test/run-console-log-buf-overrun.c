@@ -55,6 +55,12 @@ struct debug_descriptor debug_descriptor;
 
 bool flushed_to_drivers;
 
+char __rodata_start[1], __rodata_end[1];
+
+void trace_add(union trace *trace __unused, u8 type __unused, u16 len __unused)
+{
+}
+
 ssize_t console_write(bool flush_to_drivers, const void *buf, size_t count)
 {
 	flushed_to_drivers = flush_to_drivers;
@@ -33,6 +33,19 @@ static inline unsigned long mftb(void)
 
 int _printf(const char* fmt, ...);
 
+#include <skiboot.h>
+
+/* Only these count as skiboot's read-only data */
+static const char test_fmt[] = "%d %lx %*s %s";
+static const char test_fmt_float[] = "%f";
+
+#define is_rodata(p) fake_is_rodata(p)
+
+static inline bool fake_is_rodata(const void *p)
+{
+	return p == test_fmt || p == test_fmt_float;
+}
+
 #include "../console-log.c"
 
 struct debug_descriptor debug_descriptor;
@@ -40,6 +53,18 @@ struct debug_descriptor debug_descriptor;
 bool flushed_to_drivers;
 char console_buffer[4096];
 
+char __rodata_start[1], __rodata_end[1];
+
+union trace traced;
+u16 traced_len;
+
+void trace_add(union trace *trace, u8 type, u16 len)
+{
+	trace->hdr.type = type;
+	traced = *trace;
+	traced_len = len;
+}
+
 ssize_t console_write(bool flush_to_drivers, const void *buf, size_t count)
 {
 	flushed_to_drivers = flush_to_drivers;
@@ -70,5 +95,38 @@ int main(void)
 	assert(strcmp(console_buffer, "[    0.000000042,5] Hello World") == 0);
 	assert(flushed_to_drivers==true);
 
+	// Binary records only replace messages that stay in memory
+	debug_descriptor.trace_mask = 1ul << TRACE_PRLOG;
+	memset(console_buffer, 0, sizeof(console_buffer));
+	prlog(PR_NOTICE, "Hello World");
+	assert(strcmp(console_buffer, "[    0.000000042,5] Hello World") == 0);
+	assert(traced_len == 0);
+
+	memset(console_buffer, 0, sizeof(console_buffer));
+	prlog(PR_DEBUG, test_fmt, -1, 0x1234567890ul, 3, "ab", "cd");
+	assert(console_buffer[0] == 0);
+	assert(traced.hdr.type == TRACE_PRLOG);
+	assert(traced.prlog.level == PR_DEBUG);
+	assert(traced.prlog.nargs == 5);
+	assert(be16_to_cpu(traced.prlog.str_mask) == 0x18);
+	assert(traced_len == offsetof(struct trace_prlog, data) + 5 * 8);
+	assert(be64_to_cpu(((__be64 *)traced.prlog.data)[0]) == -1ull);
+	assert(be64_to_cpu(((__be64 *)traced.prlog.data)[1]) == 0x1234567890ul);
+	assert(be64_to_cpu(((__be64 *)traced.prlog.data)[2]) == 3);
+	assert(strcmp((char *)&traced.prlog.data[24], "ab") == 0);
+	assert(strcmp((char *)&traced.prlog.data[32], "cd") == 0);
+
+	// Unsupported conversions fall back to text
+	traced_len = 0;
+	prlog(PR_DEBUG, test_fmt_float, 1.0);
+	assert(traced_len == 0);
+	assert(console_buffer[0] != 0);
+
+	// As do format strings that won't be there when it's decoded
+	memset(console_buffer, 0, sizeof(console_buffer));
+	prlog(PR_DEBUG, "%d", 1);
+	assert(traced_len == 0);
+	assert(strcmp(console_buffer, "[    0.000000042,7] 1") == 0);
+
 	return 0;
 }
@@ -0,0 +1,215 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* Don't include these: PPC-specific */
+#define __CPU_H
+#define __PROCESSOR_H
+
+static inline void lwsync(void) { }
+
+struct cpu_thread {
+	bool con_suspend;
+	bool con_need_flush;
+};
+
+static struct cpu_thread fake_cpu;
+
+static inline struct cpu_thread *this_cpu(void)
+{
+	return &fake_cpu;
+}
+
+#include <skiboot.h>
+#include <lock.h>
+
+void lock(struct lock *l)
+{
+	assert(!l->lock_val);
+	l->lock_val = 1;
+}
+
+void unlock(struct lock *l)
+{
+	assert(l->lock_val);
+	l->lock_val = 0;
+}
+
+bool lock_recursive(struct lock *l)
+{
+	if (l->lock_val)
+		return false;
+	lock(l);
+	return true;
+}
+
+#include "../console.c"
+
+struct dt_node *opal_node, *dt_chosen;
+uint64_t top_of_ram;
+
+void _prlog(int log_level __unused, const char *fmt __unused, ...) { }
+
+void __opal_register(uint64_t token __unused, void *func __unused,
+		     unsigned num_args __unused) { }
+void opal_add_poller(void (*poller)(void *data) __unused,
+		     void *data __unused) { }
+void opal_update_pending_evt(uint64_t evt_mask __unused,
+			     uint64_t evt_values __unused) { }
+bool dt_has_node_property(const struct dt_node *node __unused,
+			  const char *name __unused,
+			  const char *val __unused) { return false; }
+
+/* Only used to add the dummy console nodes, which we don't */
+struct dt_node *dt_find_by_name(struct dt_node *root __unused,
+				const char *name __unused) { return NULL; }
+struct dt_node *dt_new(struct dt_node *parent __unused,
+		       const char *name __unused) { return NULL; }
+struct dt_node *dt_new_addr(struct dt_node *parent __unused,
+			    const char *name __unused,
+			    uint64_t unit_addr __unused) { return NULL; }
+struct dt_property *__dt_add_property_cells(struct dt_node *node __unused,
+					    const char *name __unused,
+					    int count __unused, ...) { return NULL; }
+struct dt_property *dt_add_property_string(struct dt_node *node __unused,
+					   const char *name __unused,
+					   const char *value __unused) { return NULL; }
+struct dt_property *__dt_find_property(struct dt_node *node __unused,
+				       const char *name __unused) { return NULL; }
+void dt_del_property(struct dt_node *node __unused,
+		     struct dt_property *prop __unused) { }
+
+/* A UART with a FIFO that only drains when we say so */
+#define FIFO_SIZE	4
+
+static char uart_out[256];
+static size_t uart_len, fifo_room;
+
+/* A slow UART: a character's worth of room every time we poke it */
+static bool fifo_trickle;
+
+static size_t fake_uart_write(const char *buf, size_t len)
+{
+	if (fifo_trickle && !fifo_room)
+		fifo_room = 1;
+	len = MIN(len, fifo_room);
+	memcpy(uart_out + uart_len, buf, len);
+	uart_len += len;
+	fifo_room -= len;
+	return len;
+}
+
+static struct con_ops fake_uart = {
+	.write = fake_uart_write,
+};
+
+static void drain_uart(void)
+{
+	do {
+		fifo_room = FIFO_SIZE;
+	} while (flush_console());
+	uart_out[uart_len] = 0;
+}
+
+static void con_puts(bool flush_to_drivers, const char *s)
+{
+	console_write(flush_to_drivers, s, strlen(s));
+}
+
+int main(void)
+{
+	con_buf = calloc(1, INMEM_CON_LEN);
+	assert(con_buf);
+	set_console(&fake_uart);
+
+	/* Nothing pending, the memory-only message is just skipped */
+	fifo_room = FIFO_SIZE;
+	con_puts(false, "mem\n");
+	con_puts(true, "abc\n");
+	drain_uart();
+	assert(!strcmp(uart_out, "abc\r\n"));
+	assert(!con_nr_skips);
+
+	/*
+	 * A memory-only message between two driver messages while the
+	 * first one is still going out doesn't cut it short.
+	 */
+	uart_len = 0;
+	fifo_room = FIFO_SIZE;
+	con_puts(true, "notice one\n");
+	assert(uart_len == FIFO_SIZE);
+	con_puts(false, "info\n");
+	con_puts(false, "debug\n");
+	con_puts(true, "notice two\n");
+	con_puts(false, "info again\n");
+	drain_uart();
+	assert(!strcmp(uart_out, "notice one\r\nnotice two\r\n"));
+	assert(!con_nr_skips);
+
+	/* It's all still in the memory console */
+	assert(strstr(con_buf, "notice one\r\ninfo\r\ndebug\r\nnotice two\r\n"
+		      "info again\r\n"));
+
+	/* A run of memory-only messages only needs one slot */
+	uart_len = 0;
+	fifo_room = 0;
+	con_puts(true, "x");
+	for (int i = 0; i < CON_MAX_SKIPS * 4; i++)
+		con_puts(false, "m");
+	assert(con_nr_skips == 1);
+	con_puts(true, "y");
+	drain_uart();
+	assert(!strcmp(uart_out, "xy"));
+
+	/*
+	 * More of them interleaved with driver output than we can remember:
+	 * the driver is drained to make room rather than the memory-only
+	 * messages leaking out.
+	 */
+	uart_len = 0;
+	fifo_room = 0;
+	fifo_trickle = true;
+	for (int i = 0; i < CON_MAX_SKIPS * 2; i++) {
+		con_puts(true, "x");
+		con_puts(false, "m");
+	}
+	fifo_trickle = false;
+	assert(con_nr_skips <= CON_MAX_SKIPS);
+	drain_uart();
+	assert(uart_len == CON_MAX_SKIPS * 2 && !strchr(uart_out, 'm'));
+
+	/*
+	 * And if the driver doesn't take anything at all, the memory-only
+	 * messages still don't go out. What was in between them is only in
+	 * the memory console then.
+	 */
+	uart_len = 0;
+	fifo_room = 0;
+	for (int i = 0; i < CON_MAX_SKIPS * 2; i++) {
+		con_puts(true, "x");
+		con_puts(false, "m");
+	}
+	assert(con_nr_skips == CON_MAX_SKIPS);
+	drain_uart();
+	assert(uart_len && !strchr(uart_out, 'm'));
+
+	free(con_buf);
+	return 0;
+}
@@ -0,0 +1,263 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Decompress a multi-block XZ stream with the blocks split out as CPU
+ * jobs, and again as flash_load_xz() reads it out of a partition.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdarg.h>
+
+#define __TEST__
+#include <skiboot.h>
+
+static uint64_t stamp;
+#define mftb()	(stamp)
+
+unsigned long tb_hz = 512000000;
+
+#define zalloc(bytes) calloc((bytes), 1)
+
+/* Make the next few block copies fail */
+static int fail_mallocs;
+
+static void *test_malloc(size_t size)
+{
+	if (fail_mallocs) {
+		fail_mallocs--;
+		return NULL;
+	}
+	return malloc(size);
+}
+
+#define malloc(size) test_malloc(size)
+#undef pr_fmt
+#include "../decompress.c"
+#undef malloc
+
+#include "../flash-xz.c"
+
+#include "../../libxz/xz_crc32.c"
+#include "../../libxz/xz_dec_stream.c"
+#include "../../libxz/xz_dec_lzma2.c"
+
+static unsigned int nr_jobs;
+
+struct cpu_job {
+	bool complete;
+};
+
+/* Jobs just run there and then */
+struct cpu_job *__cpu_queue_job(struct cpu_thread *cpu __unused,
+				const char *name __unused,
+				void (*func)(void *data), void *data,
+				bool no_return __unused)
+{
+	struct cpu_job *job = zalloc(sizeof(struct cpu_job));
+
+	nr_jobs++;
+	func(data);
+	job->complete = true;
+	return job;
+}
+
+void cpu_wait_job(struct cpu_job *job, bool free_it)
+{
+	assert(job->complete);
+	if (free_it)
+		free(job);
+}
+
+/* A partition in flash, with a bit of room in front of it */
+static uint8_t flash[0x100 + 4096];
+static int flash_rc;
+
+int blocklevel_read(struct blocklevel_device *bl __unused, uint64_t pos,
+		    void *buf, uint64_t len)
+{
+	assert(pos + len <= sizeof(flash));
+	if (flash_rc)
+		return flash_rc;
+	memcpy(buf, flash + pos, len);
+	return 0;
+}
+
+/*
+ * for i in range(1000): "skiboot %05d\n" % i, compressed with
+ * xz --check=crc32 --block-size=4096, which makes four blocks
+ */
+#define TEST_LINES	1000
+#define TEST_SIZE	(TEST_LINES * 14)
+
+static uint8_t test_xz[] = {
+	0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x01, 0x69, 0x22, 0xde, 0x36,
+	0x03, 0xc0, 0xf6, 0x01, 0x80, 0x20, 0x21, 0x01, 0x16, 0x00, 0x00, 0x00,
+	0x54, 0x9b, 0xaf, 0xbf, 0xe0, 0x0f, 0xff, 0x00, 0xee, 0x5d, 0x00, 0x39,
+	0x9a, 0xc9, 0x62, 0x09, 0x9e, 0xb2, 0x24, 0xdd, 0xa0, 0xa6, 0xb6, 0x9a,
+	0x1d, 0xd4, 0x15, 0xb5, 0xbd, 0xe9, 0xf6, 0x6d, 0xbf, 0xb4, 0x55, 0x0c,
+	0xd2, 0xfa, 0x52, 0x5e, 0xe2, 0xbb, 0x0b, 0x13, 0x2e, 0x68, 0x94, 0xa6,
+	0x28, 0xff, 0x7f, 0x97, 0x55, 0x95, 0xf2, 0x04, 0x56, 0xf3, 0x1e, 0x68,
+	0x2c, 0xbd, 0x6e, 0x6b, 0x8f, 0xa3, 0x1d, 0x50, 0xb5, 0x9f, 0x3d, 0xc6,
+	0x68, 0x4c, 0xe0, 0xe1, 0x27, 0xbe, 0x97, 0xe1, 0x18, 0x11, 0xe1, 0xd8,
+	0xcd, 0xd6, 0xe0, 0xac, 0x7e, 0xd8, 0x5b, 0x45, 0x35, 0x60, 0xb9, 0xfb,
+	0x43, 0xc8, 0x26, 0x86, 0xdc, 0x77, 0x7c, 0xf1, 0xb1, 0xa3, 0x75, 0x00,
+	0xcd, 0x6b, 0x92, 0xf1, 0xad, 0x91, 0x68, 0x93, 0xc2, 0xf2, 0xe8, 0xad,
+	0x50, 0xf9, 0xa2, 0x6d, 0x8c, 0xa8, 0x34, 0x60, 0x4e, 0x57, 0x0b, 0x65,
+	0xcf, 0x4f, 0xe4, 0x84, 0x68, 0x9f, 0xf0, 0x05, 0xae, 0x5e, 0x4c, 0x44,
+	0x8a, 0xd8, 0x1d, 0x1d, 0x79, 0xc5, 0x8d, 0x82, 0x79, 0x5b, 0x44, 0xc3,
+	0xd7, 0x5a, 0xf4, 0x8a, 0xa3, 0xd0, 0x77, 0xce, 0xdd, 0x91, 0xad, 0x3d,
+	0x30, 0x6a, 0xe6, 0x6b, 0xdd, 0x99, 0x35, 0xf8, 0x72, 0xaa, 0xd8, 0x2e,
+	0x5d, 0x43, 0xaf, 0x7c, 0x22, 0x94, 0x3e, 0xa3, 0xa4, 0xa4, 0xd1, 0x56,
+	0x86, 0x37, 0x61, 0x37, 0xa1, 0x8c, 0xe6, 0x37, 0x3f, 0x18, 0xf9, 0x49,
+	0x34, 0x72, 0xaf, 0x20, 0x96, 0xdc, 0x6b, 0x02, 0x0a, 0x0f, 0x1e, 0xeb,
+	0xa1, 0x7a, 0x3c, 0xb8, 0xd0, 0xa2, 0x94, 0xe0, 0x4e, 0x6e, 0x4c, 0x09,
+	0xff, 0x2b, 0xf1, 0xa2, 0xb2, 0xad, 0x38, 0x4f, 0xb9, 0xe9, 0x7d, 0x6b,
+	0x6b, 0x91, 0xbc, 0x39, 0x9e, 0xf9, 0xc7, 0x2f, 0x00, 0x00, 0x00, 0x00,
+	0xaf, 0x74, 0xfd, 0x72, 0x03, 0xc0, 0xfb, 0x01, 0x80, 0x20, 0x21, 0x01,
+	0x16, 0x00, 0x00, 0x00, 0xe4, 0x10, 0x51, 0x4a, 0xe0, 0x0f, 0xff, 0x00,
+	0xf3, 0x5d, 0x00, 0x18, 0x60, 0xc4, 0x72, 0x34, 0x2e, 0x5e, 0xee, 0xc8,
+	0x1a, 0x92, 0x3b, 0xdc, 0x18, 0xa1, 0x7a, 0xad, 0x62, 0xce, 0x39, 0x42,
+	0x9f, 0x90, 0xda, 0xe0, 0x30, 0xf7, 0x6b, 0x8c, 0xc2, 0x1b, 0xe8, 0x5d,
+	0xfe, 0x61, 0x5e, 0x1e, 0xc2, 0x84, 0x0c, 0x2a, 0x72, 0x0e, 0x78, 0x31,
+	0xba, 0x80, 0x8f, 0x8d, 0x1f, 0xad, 0xfd, 0xa8, 0x20, 0xda, 0x3e, 0x08,
+	0x3c, 0x08, 0xef, 0x0f, 0x96, 0x5f, 0xf6, 0x71, 0xd7, 0x6e, 0xf9, 0xb5,
+	0x73, 0xb6, 0xe8, 0x03, 0x6f, 0xab, 0xd3, 0x25, 0x6b, 0x30, 0x29, 0x4a,
+	0x18, 0x04, 0x01, 0xc3, 0xe4, 0xde, 0x46, 0x18, 0x36, 0xcc, 0xf3, 0x66,
+	0x7e, 0x8c, 0x4e, 0x1c, 0x22, 0xb0, 0xf6, 0x9e, 0x7f, 0xe2, 0x07, 0xb1,
+	0x30, 0x07, 0xe8, 0x7e, 0x25, 0x70, 0xea, 0x57, 0x28, 0x9d, 0xff, 0xf9,
+	0x42, 0x16, 0xee, 0xdd, 0x9f, 0x37, 0x2e, 0x20, 0x96, 0x3c, 0xc6, 0x24,
+	0xb9, 0xf3, 0xa6, 0xd4, 0x48, 0x7f, 0x16, 0x29, 0xa7, 0x04, 0xda, 0xdf,
+	0xdc, 0x97, 0xe4, 0x0d, 0x17, 0x39, 0xe8, 0xdf, 0x5c, 0xbe, 0xb5, 0x80,
+	0x76, 0x2f, 0x8c, 0x96, 0x51, 0xb7, 0x27, 0x2e, 0x24, 0x02, 0x30, 0xfc,
+	0x3b, 0xc9, 0x0a, 0x06, 0x56, 0x67, 0x3a, 0x4c, 0xce, 0x51, 0x93, 0x33,
+	0x73, 0x43, 0xd2, 0x58, 0x6f, 0xfa, 0x19, 0xc1, 0x7b, 0x4d, 0x5f, 0xa4,
+	0xa3, 0xe6, 0x31, 0xc8, 0x2c, 0xdd, 0xa0, 0x01, 0x15, 0xbc, 0x17, 0x1e,
+	0xc2, 0xc4, 0x83, 0x2f, 0x3c, 0xf1, 0xa6, 0xa1, 0xe8, 0xbd, 0x28, 0x28,
+	0xb0, 0x99, 0x76, 0x7d, 0x8e, 0x2b, 0x91, 0x8d, 0x31, 0xfe, 0xa0, 0x95,
+	0x4b, 0x33, 0xdb, 0x94, 0x4f, 0x72, 0x87, 0x67, 0xf3, 0x4d, 0x67, 0x7b,
+	0x78, 0x93, 0x1a, 0x1c, 0xd0, 0x00, 0x00, 0x00, 0x62, 0x5d, 0x33, 0x9e,
+	0x03, 0xc0, 0xd9, 0x01, 0x80, 0x20, 0x21, 0x01, 0x16, 0x00, 0x00, 0x00,
+	0x09, 0xc3, 0xf9, 0x01, 0xe0, 0x0f, 0xff, 0x00, 0xd1, 0x5d, 0x00, 0x34,
+	0x98, 0x8a, 0x57, 0xc3, 0x4b, 0x84, 0x4d, 0x10, 0x72, 0x52, 0xd5, 0xe3,
+	0x12, 0x50, 0x99, 0xc2, 0x03, 0xa8, 0x31, 0xad, 0x8b, 0xc0, 0x89, 0xb7,
+	0xb8, 0x3d, 0xda, 0x08, 0x1a, 0xc1, 0x85, 0xdd, 0xfa, 0xf4, 0x72, 0x65,
+	0x40, 0x4d, 0x30, 0x7c, 0x05, 0x24, 0xa7, 0x95, 0x22, 0x91, 0xec, 0x0a,
+	0x54, 0xea, 0xe8, 0xba, 0xbe, 0x0c, 0x3d, 0x80, 0x32, 0x06, 0xb1, 0x24,
+	0xa0, 0x04, 0x54, 0x5d, 0x6f, 0xeb, 0x76, 0x7a, 0xe1, 0x17, 0x83, 0x02,
+	0xf1, 0x13, 0x15, 0x08, 0x2b, 0x89, 0x54, 0x79, 0xbf, 0xf5, 0x6a, 0x95,
+	0x7e, 0x1e, 0x6e, 0xea, 0xd4, 0xbb, 0x5b, 0x6a, 0x55, 0xbc, 0xbb, 0x5a,
+	0xbc, 0xae, 0x49, 0x61, 0x95, 0xcd, 0x26, 0x99, 0x06, 0x72, 0xf7, 0x36,
+	0x9b, 0x0e, 0xfd, 0xbd, 0x5c, 0xbd, 0x47, 0x02, 0x5c, 0x5e, 0x79, 0x67,
+	0xdd, 0x71, 0xfb, 0xc2, 0x86, 0x0c, 0x3a, 0x5e, 0xfa, 0x56, 0x45, 0xdd,
+	0x5b, 0x1e, 0x2c, 0x09, 0xcc, 0x5f, 0x51, 0x4a, 0x6e, 0xb5, 0x0f, 0x4c,
+	0xb0, 0x02, 0xfa, 0xf5, 0x2d, 0x3c, 0xf5, 0xc6, 0xe4, 0x01, 0x17, 0x54,
+	0x14, 0x82, 0xcf, 0xe0, 0x18, 0xe0, 0xf3, 0x45, 0x3b, 0x5e, 0xcd, 0xcf,
+	0xab, 0x03, 0xc7, 0xb8, 0xde, 0xf0, 0x44, 0xd2, 0x4d, 0xfd, 0x7a, 0xfc,
+	0x63, 0x21, 0xa5, 0xdb, 0x4b, 0x94, 0x2c, 0xdb, 0x34, 0x0b, 0x00, 0x9d,
+	0x6e, 0xe2, 0x30, 0xbe, 0x27, 0x76, 0x7d, 0x48, 0x19, 0xcb, 0xda, 0x43,
+	0x09, 0xb8, 0x2c, 0xad, 0x00, 0x00, 0x00, 0x00, 0xa2, 0xa4, 0x1c, 0x8f,
+	0x03, 0xc0, 0xa4, 0x01, 0xb0, 0x0d, 0x21, 0x01, 0x16, 0x00, 0x00, 0x00,
+	0x00, 0xc6, 0xe9, 0x29, 0xe0, 0x06, 0xaf, 0x00, 0x9c, 0x5d, 0x00, 0x1c,
+	0x0d, 0xec, 0x14, 0x77, 0x38, 0xcc, 0x87, 0x71, 0xc1, 0x55, 0x11, 0x81,
+	0xb6, 0xf6, 0x44, 0x25, 0xcb, 0xd5, 0x7c, 0x11, 0xce, 0x9b, 0x45, 0xcd,
+	0xe9, 0xab, 0x6c, 0x06, 0x48, 0x41, 0x2e, 0x40, 0x7e, 0xac, 0xae, 0x7a,
+	0xce, 0x9f, 0x4e, 0xbb, 0x51, 0x91, 0x54, 0x45, 0xd9, 0x12, 0x94, 0x92,
+	0x18, 0xcb, 0x0e, 0x79, 0x25, 0x19, 0xf1, 0x68, 0x96, 0xe0, 0x4d, 0x70,
+	0x1c, 0xed, 0x5b, 0x6d, 0x1b, 0x64, 0xcb, 0x72, 0x95, 0x62, 0xeb, 0xbe,
+	0x34, 0x7d, 0x2f, 0x49, 0x10, 0xad, 0xbb, 0xb1, 0x8a, 0x15, 0xf7, 0x77,
+	0x43, 0x9b, 0xf8, 0x6b, 0xce, 0x42, 0xbd, 0x25, 0xac, 0xa5, 0xce, 0x1a,
+	0x9a, 0xa4, 0x16, 0x0a, 0xdf, 0xdc, 0xe2, 0x8d, 0x97, 0xd2, 0xb2, 0xd4,
+	0x6b, 0x57, 0xd9, 0xd9, 0x54, 0xc4, 0x76, 0xbb, 0xf4, 0x36, 0x3a, 0xb1,
+	0x0e, 0xd8, 0xfb, 0x7c, 0x33, 0x39, 0x93, 0x8b, 0x74, 0x62, 0x7e, 0xd9,
+	0xc5, 0x14, 0x3d, 0x65, 0x9a, 0x64, 0xb1, 0x6c, 0x64, 0xfc, 0xf5, 0x14,
+	0x9a, 0x69, 0x93, 0xcb, 0x10, 0x09, 0x1d, 0x64, 0xaa, 0xf7, 0x00, 0x00,
+	0xe3, 0x03, 0x07, 0xcb, 0x00, 0x04, 0x8a, 0x02, 0x80, 0x20, 0x8f, 0x02,
+	0x80, 0x20, 0xed, 0x01, 0x80, 0x20, 0xb8, 0x01, 0xb0, 0x0d, 0x00, 0x00,
+	0x01, 0xb3, 0x05, 0x9e, 0x86, 0x00, 0x08, 0x96, 0x05, 0x00, 0x00, 0x00,
+	0x00, 0x01, 0x59, 0x5a,
+};
+
+static char expect[TEST_SIZE + 1];
+static char out[TEST_SIZE + 64];
+static char part_out[TEST_SIZE + sizeof(flash)];
+
+int main(void)
+{
+	size_t len, i;
+
+	for (i = 0; i < TEST_LINES; i++)
+		snprintf(expect + i * 14, 15, "skiboot %05zu\n", i);
+
+	/* Blocks 1-3 go out as jobs, we do block 0 */
+	assert(xz_decompress(out, sizeof(out), test_xz, sizeof(test_xz),
+			     &len) == 0);
+	assert(nr_jobs == 3);
+	assert(len == TEST_SIZE);
+	assert(memcmp(out, expect, TEST_SIZE) == 0);
+
+	/* A block that can't get memory sends us back to the serial path */
+	memset(out, 0, sizeof(out));
+	fail_mallocs = 1;
+	assert(xz_decompress(out, sizeof(out), test_xz, sizeof(test_xz),
+			     &len) == 0);
+	assert(!fail_mallocs);
+	assert(len == TEST_SIZE);
+	assert(memcmp(out, expect, TEST_SIZE) == 0);
+
+	/* Not enough room */
+	assert(xz_decompress(out, TEST_SIZE - 1, test_xz, sizeof(test_xz),
+			     NULL) == -1);
+
+	/* Damage in one block fails the lot */
+	test_xz[sizeof(test_xz) / 2] ^= 0x10;
+	assert(xz_decompress(out, sizeof(out), test_xz, sizeof(test_xz),
+			     NULL) == -1);
+	test_xz[sizeof(test_xz) / 2] ^= 0x10;
+
+	/* A damaged index means we can't split it, nor decompress it */
+	nr_jobs = 0;
+	test_xz[sizeof(test_xz) - 20] ^= 0x01;
+	assert(xz_decompress(out, sizeof(out), test_xz, sizeof(test_xz),
+			     NULL) == -1);
+	assert(nr_jobs == 0);
+	test_xz[sizeof(test_xz) - 20] ^= 0x01;
+
+	/* From a partition, with erased flash after the stream */
+	nr_jobs = 0;
+	memset(flash, 0xff, sizeof(flash));
+	memcpy(flash + 0x100, test_xz, sizeof(test_xz));
+	assert(flash_load_xz(NULL, 0x100, sizeof(flash) - 0x100, part_out,
+			     sizeof(part_out), &len) == 0);
+	assert(nr_jobs == 3);
+	assert(len == TEST_SIZE);
+	assert(memcmp(part_out, expect, TEST_SIZE) == 0);
+
+	/* Partition bigger than the buffer */
+	assert(flash_load_xz(NULL, 0, sizeof(out), out, sizeof(out),
+			     &len) == -1);
+
+	/* Flash read errors are passed back */
+	flash_rc = -2;
+	assert(flash_load_xz(NULL, 0x100, sizeof(test_xz), part_out,
+			     sizeof(part_out), &len) == -2);
+	flash_rc = 0;
+
+	return 0;
+}
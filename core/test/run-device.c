@@ -367,6 +367,15 @@ int main(void)
 
 	assert(is_sorted(root));
 
+	/* Out of order and duplicates of the last node */
+	assert(dt_new(root, "c@4") == NULL);
+	dt_new(root, "a@0");
+	dt_new(root, "b@10");
+	dt_new(root, "c@5");
+
+	assert(is_sorted(root));
+	assert(dt_new(root, "c@5") == NULL);
+
 	dt_free(root);
 
 	/* Test child node sorting */
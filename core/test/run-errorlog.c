@@ -0,0 +1,218 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Check that a storm of identical errors reaches the platform backend
+ * as a single log carrying an occurrence count, and that panics and
+ * distinct errors (including the same reason with different user data)
+ * aren't held back or merged.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdarg.h>
+
+#define __TEST__
+#include <skiboot.h>
+#include <lock.h>
+#include <errorlog.h>
+#include <timer.h>
+
+static uint64_t stamp;
+#define mftb()	(stamp)
+
+void lock(struct lock *l __unused)
+{
+}
+
+void unlock(struct lock *l __unused)
+{
+}
+
+bool try_lock(struct lock *l __unused)
+{
+	return true;
+}
+
+unsigned long tb_hz = 512000000;
+
+#include "../errorlog.c"
+#include "../pool.c"
+
+#define TEST_ERROR	0x1234
+#define TEST_OTHER	0x1235
+#define TEST_PANIC	0x1236
+#define TEST_STORM	50
+
+DEFINE_LOG_ENTRY(TEST_ERROR, OPAL_PLATFORM_ERR_EVT, OPAL_CEC,
+		 OPAL_PLATFORM_FIRMWARE, OPAL_PREDICTIVE_ERR_GENERAL, OPAL_NA);
+DEFINE_LOG_ENTRY(TEST_OTHER, OPAL_PLATFORM_ERR_EVT, OPAL_CEC,
+		 OPAL_PLATFORM_FIRMWARE, OPAL_PREDICTIVE_ERR_GENERAL, OPAL_NA);
+DEFINE_LOG_ENTRY(TEST_PANIC, OPAL_PLATFORM_ERR_EVT, OPAL_CEC,
+		 OPAL_PLATFORM_FIRMWARE, OPAL_ERROR_PANIC, OPAL_NA);
+
+struct platform platform;
+
+static uint64_t timer_target;
+
+void init_timer(struct timer *t, timer_func_t expiry, void *data)
+{
+	t->expiry = expiry;
+	t->user_data = data;
+}
+
+void schedule_timer_at(struct timer *t __unused, uint64_t when)
+{
+	timer_target = when;
+}
+
+uint64_t schedule_timer(struct timer *t, uint64_t how_long)
+{
+	schedule_timer_at(t, mftb() + how_long);
+	return timer_target;
+}
+
+static void run_timer(void)
+{
+	uint64_t target = timer_target;
+
+	timer_target = 0;
+	stamp = target;
+	elog_timer.expiry(&elog_timer, NULL, target);
+}
+
+static struct errorlog *logged[8];
+static unsigned int nr_logged;
+
+static int test_elog_commit(struct errorlog *elog)
+{
+	assert(nr_logged < ARRAY_SIZE(logged));
+	logged[nr_logged++] = elog;
+	return 0;
+}
+
+static void done(void)
+{
+	while (nr_logged)
+		opal_elog_complete(logged[--nr_logged], true);
+}
+
+static struct elog_user_data_section *find_section(struct errorlog *elog,
+						   uint32_t tag)
+{
+	struct elog_user_data_section *s;
+	char *p = elog->user_data_dump;
+	int i;
+
+	for (i = 0; i < elog->user_section_count; i++) {
+		s = (struct elog_user_data_section *)p;
+		if (s->tag == tag)
+			return s;
+		p += s->size;
+	}
+	return NULL;
+}
+
+int main(void)
+{
+	struct elog_user_data_section *s;
+	uint32_t plid, first_plid = 0;
+	int i;
+
+	platform.elog_commit = test_elog_commit;
+	assert(elog_init() == 0);
+
+	/* A panic goes straight out */
+	log_simple_error(&e_info(TEST_PANIC), "panic\n");
+	assert(nr_logged == 1 && !timer_target);
+	done();
+
+	/* A storm ends up as the first log of it, with a count */
+	for (i = 0; i < TEST_STORM; i++) {
+		stamp += 1000;
+		plid = log_simple_error(&e_info(TEST_ERROR), "storm\n");
+		assert(plid != (uint32_t)-1);
+		if (i == 0) {
+			first_plid = plid;
+			assert(timer_target == stamp +
+			       msecs_to_tb(ELOG_COALESCE_MS));
+		}
+
+		/* The PLID handed back is the one that reaches the backend */
+		assert(plid == first_plid);
+	}
+	log_simple_error(&e_info(TEST_OTHER), "other\n");
+	assert(nr_logged == 0);
+
+	/* Each goes out once it has been held for the whole window */
+	run_timer();
+	assert(nr_logged == 1);
+	assert(timer_target);
+	run_timer();
+	assert(nr_logged == 2);
+	assert(elog_nr_merged == TEST_STORM - 1);
+
+	assert(logged[0]->reason_code == TEST_ERROR);
+	assert(logged[0]->plid == first_plid);
+	assert(logged[0]->occurrences == TEST_STORM);
+	s = find_section(logged[0], ELOG_OCCURRENCE_TAG);
+	assert(s);
+	assert(!memcmp(s->data_dump, "Occurred 50 times", 17));
+
+	assert(logged[1]->reason_code == TEST_OTHER);
+	assert(logged[1]->occurrences == 1);
+	assert(!find_section(logged[1], ELOG_OCCURRENCE_TAG));
+
+	/* The duplicates went back to the pool already */
+	assert(elog_pool.free_count == ELOG_WRITE_MAX_RECORD - 2);
+	done();
+
+	/* Once it's gone out, the same error makes a new log */
+	log_simple_error(&e_info(TEST_ERROR), "again\n");
+	run_timer();
+	assert(nr_logged == 1 && logged[0]->occurrences == 1);
+	done();
+
+	/* Same reason but different messages, they're all kept */
+	log_simple_error(&e_info(TEST_ERROR), "chip 0\n");
+	log_simple_error(&e_info(TEST_ERROR), "chip 1\n");
+	log_simple_error(&e_info(TEST_ERROR), "chip 0\n");
+	run_timer();
+	assert(nr_logged == 2 && !elog_nr_pending);
+	assert(!memcmp(logged[0]->user_data_dump +
+		       sizeof(struct elog_user_data_section) - 1, "chip 0", 6));
+	assert(logged[0]->occurrences == 2);
+	assert(!memcmp(logged[1]->user_data_dump +
+		       sizeof(struct elog_user_data_section) - 1, "chip 1", 6));
+	assert(logged[1]->occurrences == 1);
+	done();
+
+	/* On the way to a reboot, they go out without waiting */
+	log_simple_error(&e_info(TEST_ERROR), "error\n");
+	log_simple_error(&e_info(TEST_OTHER), "other\n");
+	log_simple_error(&e_info(TEST_ERROR), "error\n");
+	assert(nr_logged == 0);
+	elog_flush_pending();
+	assert(nr_logged == 2 && !elog_nr_pending);
+	assert(logged[0]->reason_code == TEST_ERROR);
+	assert(logged[0]->occurrences == 2);
+	done();
+
+	assert(elog_pool.free_count == ELOG_WRITE_MAX_RECORD);
+	return 0;
+}
@@ -179,6 +179,11 @@ static void trace_add_dt_props(void)
 
 	tmask = (uint64_t)&debug_descriptor.trace_mask;
 	dt_add_property_u64(opal_node, "ibm,opal-trace-mask", tmask);
+
+	/* Where the format strings of TRACE_PRLOG entries live */
+	dt_add_property_u64s(opal_node, "ibm,opal-trace-strings",
+			     (uint64_t)__rodata_start,
+			     __rodata_end - __rodata_start);
 }
 
 static void trace_add_desc(struct trace_info *t, uint64_t size)
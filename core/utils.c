@@ -21,6 +21,7 @@
 #include <processor.h>
 #include <cpu.h>
 #include <stack.h>
+#include <errorlog.h>
 
 extern unsigned long __stack_chk_guard;
 unsigned long __stack_chk_guard = 0xdeadf00dbaad300dULL;
@@ -49,6 +50,10 @@ void __noreturn _abort(const char *msg)
 	prlog(PR_EMERG, "Aborting!\n");
 	backtrace();
 
+	/* Only if we can, we may have died holding any lock */
+	if (!this_cpu()->lock_depth)
+		elog_flush_pending();
+
 	if (platform.terminate)
 		platform.terminate(msg);
 
@@ -0,0 +1,269 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <err.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../../ccan/endian/endian.h"
+#include "../../ccan/short_types/short_types.h"
+#include <bootprof_types.h>
+
+#define DEFAULT_PATH	"/sys/firmware/opal/exports/boot_profile"
+
+struct entry {
+	uint64_t start;
+	uint64_t end;
+	uint32_t pir;
+	u8 type;
+	char name[BOOTPROF_NAME_LEN + 1];
+};
+
+/* Per job name totals */
+struct job_sum {
+	const char *name;
+	unsigned int count;
+	uint64_t total;
+	uint64_t max;
+};
+
+static uint64_t tb_hz;
+
+static double tb_to_ms(uint64_t tb)
+{
+	return (double)tb * 1000 / tb_hz;
+}
+
+static void *read_file(const char *path, size_t *len)
+{
+	size_t size = 0, max = 0x10000;
+	char *buf = NULL;
+	ssize_t n;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		err(1, "Opening %s", path);
+
+	do {
+		if (size == max || !buf) {
+			if (buf)
+				max *= 2;
+			buf = realloc(buf, max);
+			if (!buf)
+				err(1, "Allocating %zu bytes", max);
+		}
+		n = read(fd, buf + size, max - size);
+		if (n < 0)
+			err(1, "Reading %s", path);
+		size += n;
+	} while (n);
+
+	close(fd);
+	*len = size;
+	return buf;
+}
+
+static int parse(const void *buf, size_t len, struct entry **entries)
+{
+	const struct bootprof_hdr *hdr = buf;
+	const struct bootprof_entry *e;
+	unsigned int i, nr, entry_size;
+	struct entry *out;
+
+	if (len < sizeof(*hdr))
+		errx(1, "Profile too short (%zu bytes)", len);
+	if (be32_to_cpu(hdr->magic) != BOOTPROF_MAGIC)
+		errx(1, "Bad magic 0x%08x", be32_to_cpu(hdr->magic));
+	if (be16_to_cpu(hdr->version) != BOOTPROF_VERSION)
+		errx(1, "Unknown version %u", be16_to_cpu(hdr->version));
+
+	entry_size = be16_to_cpu(hdr->entry_size);
+	if (entry_size < sizeof(*e))
+		errx(1, "Entries too small (%u bytes)", entry_size);
+
+	nr = be32_to_cpu(hdr->nr_entries);
+	if (nr > be32_to_cpu(hdr->max_entries) ||
+	    sizeof(*hdr) + (size_t)nr * entry_size > len)
+		errx(1, "Profile truncated (%u entries in %zu bytes)", nr, len);
+
+	tb_hz = be64_to_cpu(hdr->tb_hz);
+	if (!tb_hz)
+		errx(1, "No timebase frequency");
+	if (be32_to_cpu(hdr->dropped))
+		printf("Warning: %u entries didn't fit\n",
+		       be32_to_cpu(hdr->dropped));
+
+	out = calloc(nr ? nr : 1, sizeof(*out));
+	if (!out)
+		err(1, "Allocating entries");
+
+	for (i = 0; i < nr; i++) {
+		e = buf + sizeof(*hdr) + (size_t)i * entry_size;
+		out[i].start = be64_to_cpu(e->start);
+		out[i].end = be64_to_cpu(e->end);
+		out[i].pir = be32_to_cpu(e->pir);
+		out[i].type = e->type;
+		memcpy(out[i].name, e->name, BOOTPROF_NAME_LEN);
+	}
+
+	*entries = out;
+	return nr;
+}
+
+static int cmp_start(const void *a, const void *b)
+{
+	const struct entry *ea = a, *eb = b;
+
+	if (ea->start != eb->start)
+		return ea->start < eb->start ? -1 : 1;
+	/* Phases before the jobs they start */
+	return ea->type - eb->type;
+}
+
+static int cmp_total(const void *a, const void *b)
+{
+	const struct job_sum *sa = a, *sb = b;
+
+	if (sa->total != sb->total)
+		return sa->total > sb->total ? -1 : 1;
+	return 0;
+}
+
+static void print_entries(struct entry *entries, int nr, uint64_t base,
+			  bool jobs)
+{
+	int i;
+
+	printf("%12s %12s  %4s  %s\n", "start(ms)", "time(ms)", "cpu", "name");
+	for (i = 0; i < nr; i++) {
+		struct entry *e = &entries[i];
+
+		if (e->type == BOOTPROF_JOB && !jobs)
+			continue;
+
+		printf("%12.3f ", tb_to_ms(e->start - base));
+		if (e->end && e->end >= e->start)
+			printf("%12.3f ", tb_to_ms(e->end - e->start));
+		else
+			printf("%12s ", "-");
+		printf(" %04x  %s%s\n", e->pir,
+		       e->type == BOOTPROF_JOB ? "  job " : "", e->name);
+	}
+}
+
+static void print_job_sums(struct entry *entries, int nr)
+{
+	struct job_sum *sums;
+	int i, j, nr_sums = 0;
+
+	sums = calloc(nr ? nr : 1, sizeof(*sums));
+	if (!sums)
+		err(1, "Allocating job totals");
+
+	for (i = 0; i < nr; i++) {
+		struct entry *e = &entries[i];
+		uint64_t t = e->end - e->start;
+
+		/* Older skiboots recorded jobs across the timebase reset */
+		if (e->type != BOOTPROF_JOB || e->end < e->start)
+			continue;
+
+		for (j = 0; j < nr_sums; j++)
+			if (!strcmp(sums[j].name, e->name))
+				break;
+		if (j == nr_sums)
+			sums[nr_sums++].name = e->name;
+		sums[j].count++;
+		sums[j].total += t;
+		if (t > sums[j].max)
+			sums[j].max = t;
+	}
+
+	if (!nr_sums)
+		goto out;
+
+	qsort(sums, nr_sums, sizeof(*sums), cmp_total);
+
+	printf("\n%6s %12s %12s  %s\n", "jobs", "total(ms)", "max(ms)",
+	       "name");
+	for (j = 0; j < nr_sums; j++)
+		printf("%6u %12.3f %12.3f  %s\n", sums[j].count,
+		       tb_to_ms(sums[j].total), tb_to_ms(sums[j].max),
+		       sums[j].name);
+out:
+	free(sums);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-j] [file]\n", prog);
+	fprintf(stderr, "  Print the skiboot boot profile, from %s by default\n",
+		DEFAULT_PATH);
+	fprintf(stderr, "  -j  list each CPU job, not just the totals\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *path = DEFAULT_PATH;
+	struct entry *entries;
+	uint64_t base = 0, last = 0;
+	bool jobs = false;
+	size_t len;
+	void *buf;
+	int i, nr, opt;
+
+	while ((opt = getopt(argc, argv, "jh")) != -1) {
+		switch (opt) {
+		case 'j':
+			jobs = true;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (optind < argc)
+		path = argv[optind];
+
+	buf = read_file(path, &len);
+	nr = parse(buf, len, &entries);
+	free(buf);
+
+	qsort(entries, nr, sizeof(*entries), cmp_start);
+	for (i = 0; i < nr; i++) {
+		if (!base)
+			base = entries[i].start;
+		if (entries[i].end > last)
+			last = entries[i].end;
+	}
+
+	print_entries(entries, nr, base, jobs);
+	print_job_sums(entries, nr);
+	if (nr)
+		printf("\nTotal: %.3f ms\n", tb_to_ms(last - base));
+
+	free(entries);
+	return 0;
+}
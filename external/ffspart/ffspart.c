@@ -35,6 +35,10 @@
 /*
  * Flags:
  *  - E: ECC for this part
+ *  - X: Contents are XZ compressed. skiboot only checks CRC32 and
+ *       decompresses into the load buffer, so make them with
+ *       xz --check=crc32, and --block-size=<n> to let it decompress
+ *       the blocks in parallel.
  */
 
 /*
@@ -280,6 +284,9 @@ int main(int argc, char *argv[])
 			case 'E':
 				user.datainteg |= FFS_ENRY_INTEG_ECC;
 				break;
+			case 'X':
+				user.compresstype = FFS_COMPRESSTYPE_XZ;
+				break;
 			case 'V':
 				user.vercheck |= FFS_VERCHECK_SHA512V;
 				break;
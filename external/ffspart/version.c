@@ -0,0 +1 @@
+const char version[] = "2013c37";
@@ -0,0 +1,110 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Print a snapshot of the OCC sensors, read straight from memory.
+ *
+ *   dump_occ_sensors [-f dump-file] [sensor-name...]
+ */
+
+#include <err.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "occ_sensors.h"
+
+static void dump_occ(const struct occ_sensors *s, int occ, char **names,
+		     int nr_names)
+{
+	const void *block = occ_sensors_block(s, occ);
+	struct occ_sensor_value *values;
+	struct occ_sensor_info info;
+	int i, nr, rc, *ids;
+
+	nr = occ_sensors_count(block);
+	if (nr < 0) {
+		printf("chip %u: no sensors (%s)\n", s->chip_ids[occ],
+		       strerror(-nr));
+		return;
+	}
+
+	ids = calloc(nr, sizeof(*ids));
+	values = calloc(nr, sizeof(*values));
+	if (!ids || !values)
+		err(1, "calloc");
+
+	if (nr_names) {
+		nr = 0;
+		for (i = 0; i < nr_names; i++) {
+			rc = occ_sensors_find(block, names[i]);
+			if (rc >= 0)
+				ids[nr++] = rc;
+		}
+	} else {
+		for (i = 0; i < nr; i++)
+			ids[i] = i;
+	}
+
+	rc = nr ? occ_sensors_snapshot(block, ids, nr, values) : 0;
+	if (rc) {
+		printf("chip %u: can't read sensors (%s)\n", s->chip_ids[occ],
+		       strerror(-rc));
+		goto out;
+	}
+
+	for (i = 0; i < nr; i++) {
+		occ_sensors_info(block, ids[i], &info);
+		printf("chip %u %-16s %6u %-4s (min %u max %u) ts %016"
+		       PRIx64 "\n", s->chip_ids[occ], info.name,
+		       values[i].sample, info.units, values[i].sample_min,
+		       values[i].sample_max, values[i].timestamp);
+	}
+out:
+	free(ids);
+	free(values);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *file = NULL;
+	struct occ_sensors s;
+	int opt, occ, rc;
+
+	while ((opt = getopt(argc, argv, "f:")) != -1) {
+		switch (opt) {
+		case 'f':
+			file = optarg;
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-f dump-file] "
+				"[sensor-name...]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	rc = file ? occ_sensors_map_file(&s, file) : occ_sensors_map(&s);
+	if (rc)
+		errx(1, "can't map OCC sensor data: %s", strerror(-rc));
+
+	for (occ = 0; occ < s.nr_occs; occ++)
+		dump_occ(&s, occ, argv + optind, argc - optind);
+
+	occ_sensors_unmap(&s);
+	return 0;
+}
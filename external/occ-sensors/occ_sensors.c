@@ -0,0 +1,408 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "occ_sensors.h"
+
+#define DT_NODE		"/proc/device-tree/reserved-memory/ibm,occ-sensor-data@*"
+
+/* Sensor Data Header Block */
+#define HDR_VALID		0x00
+#define HDR_VERSION		0x01
+#define HDR_NR_SENSORS		0x02
+#define HDR_READING_VERSION	0x04
+#define HDR_NAMES_OFFSET	0x08
+#define HDR_NAMES_VERSION	0x0c
+#define HDR_NAME_LENGTH		0x0d
+#define HDR_PING_OFFSET		0x10
+#define HDR_PONG_OFFSET		0x14
+
+/* Sensor Names */
+#define NAME_LENGTH		48
+#define NAME_NAME		0x00
+#define NAME_UNITS		0x10
+#define NAME_GSID		0x14
+#define NAME_FREQ		0x16
+#define NAME_SCALE_FACTOR	0x1a
+#define NAME_TYPE		0x1e
+#define NAME_LOCATION		0x20
+#define NAME_STRUCTURE_TYPE	0x22
+#define NAME_READING_OFFSET	0x23
+
+/* Readings */
+#define READING_BUFFER_SIZE	0xa000
+#define READING_FULL		0x01
+#define READING_COUNTER		0x02
+#define FULL_SIZE		48
+#define FULL_TIMESTAMP		0x02
+#define FULL_SAMPLE		0x0a
+#define FULL_SAMPLE_MIN		0x0c
+#define FULL_SAMPLE_MAX		0x0e
+#define FULL_CSM_MIN		0x10
+#define FULL_CSM_MAX		0x12
+#define FULL_ACCUMULATOR	0x1c
+#define COUNTER_SIZE		24
+#define COUNTER_TIMESTAMP	0x02
+#define COUNTER_ACCUMULATOR	0x0a
+#define COUNTER_SAMPLE		0x12
+
+#define SNAPSHOT_RETRIES	8
+
+/* Order the reads of the readings against those of the valid byte */
+#ifndef occ_sensors_rmb
+#define occ_sensors_rmb()	__atomic_thread_fence(__ATOMIC_ACQUIRE)
+#endif
+
+/*
+ * The OCCs write this memory behind our back, so every access goes
+ * through a volatile pointer. Values are big endian.
+ */
+static uint64_t get_be(const void *block, size_t off, int len)
+{
+	const volatile uint8_t *p = (const volatile uint8_t *)block + off;
+	uint64_t v = 0;
+	int i;
+
+	for (i = 0; i < len; i++)
+		v = (v << 8) | p[i];
+	return v;
+}
+
+#define get8(b, off)	((uint8_t)get_be(b, off, 1))
+#define get16(b, off)	((uint16_t)get_be(b, off, 2))
+#define get32(b, off)	((uint32_t)get_be(b, off, 4))
+#define get64(b, off)	get_be(b, off, 8)
+
+static int read_file(const char *dir, const char *prop, void *buf, size_t len)
+{
+	char path[PATH_MAX];
+	ssize_t rc;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, prop);
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -errno;
+	rc = read(fd, buf, len);
+	close(fd);
+	if (rc < 0)
+		return -errno;
+	return rc;
+}
+
+static int map_range(struct occ_sensors *s, int fd, uint64_t addr,
+		     size_t size)
+{
+	long page = sysconf(_SC_PAGESIZE);
+	uint64_t start = addr & ~(uint64_t)(page - 1);
+
+	s->map_size = size + (addr - start);
+	s->map = mmap(NULL, s->map_size, PROT_READ, MAP_SHARED, fd, start);
+	if (s->map == MAP_FAILED) {
+		s->map = NULL;
+		return -errno;
+	}
+	s->base = (uint8_t *)s->map + (addr - start);
+	s->size = size;
+	return 0;
+}
+
+int occ_sensors_map(struct occ_sensors *s)
+{
+	uint8_t reg[16], cells[4 * OCC_SENSORS_MAX_OCCS];
+	uint64_t addr, size;
+	glob_t g;
+	int i, n, fd, rc;
+
+	memset(s, 0, sizeof(*s));
+
+	if (glob(DT_NODE, 0, NULL, &g) || g.gl_pathc != 1) {
+		globfree(&g);
+		return -ENOENT;
+	}
+
+	rc = read_file(g.gl_pathv[0], "reg", reg, sizeof(reg));
+	if (rc != sizeof(reg)) {
+		rc = rc < 0 ? rc : -EINVAL;
+		goto out;
+	}
+	addr = get64(reg, 0);
+	size = get64(reg, 8);
+
+	rc = read_file(g.gl_pathv[0], "ibm,occ-sensor-block-size", cells, 4);
+	if (rc != 4) {
+		rc = rc < 0 ? rc : -EINVAL;
+		goto out;
+	}
+	s->block_size = get32(cells, 0);
+	if (!s->block_size) {
+		rc = -EINVAL;
+		goto out;
+	}
+
+	n = read_file(g.gl_pathv[0], "ibm,chip-ids", cells, sizeof(cells));
+	s->nr_occs = size / s->block_size;
+	if (s->nr_occs > OCC_SENSORS_MAX_OCCS || n != 4 * s->nr_occs) {
+		rc = -EINVAL;
+		goto out;
+	}
+	for (i = 0; i < s->nr_occs; i++)
+		s->chip_ids[i] = get32(cells, 4 * i);
+
+	fd = open("/dev/mem", O_RDONLY | O_SYNC);
+	if (fd < 0) {
+		rc = -errno;
+		goto out;
+	}
+	rc = map_range(s, fd, addr, size);
+	close(fd);
+out:
+	globfree(&g);
+	return rc;
+}
+
+int occ_sensors_map_file(struct occ_sensors *s, const char *path)
+{
+	struct stat st;
+	int i, fd, rc;
+
+	memset(s, 0, sizeof(*s));
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -errno;
+	if (fstat(fd, &st)) {
+		rc = -errno;
+		goto out;
+	}
+
+	s->block_size = OCC_SENSORS_BLOCK_SIZE;
+	s->nr_occs = st.st_size / s->block_size;
+	if (!s->nr_occs || s->nr_occs > OCC_SENSORS_MAX_OCCS) {
+		rc = -EINVAL;
+		goto out;
+	}
+	/* A dump doesn't say, so number the chips in order */
+	for (i = 0; i < s->nr_occs; i++)
+		s->chip_ids[i] = i;
+
+	rc = map_range(s, fd, 0, s->nr_occs * s->block_size);
+out:
+	close(fd);
+	return rc;
+}
+
+void occ_sensors_unmap(struct occ_sensors *s)
+{
+	if (s->map)
+		munmap(s->map, s->map_size);
+	memset(s, 0, sizeof(*s));
+}
+
+const void *occ_sensors_block(const struct occ_sensors *s, int occ)
+{
+	if (occ < 0 || occ >= s->nr_occs)
+		return NULL;
+	return s->base + occ * s->block_size;
+}
+
+int occ_sensors_count(const void *block)
+{
+	uint32_t names, ping, pong;
+	uint16_t nr;
+
+	if (get8(block, HDR_VALID) != 1)
+		return -ENODATA;
+
+	if (get8(block, HDR_VERSION) != 1 ||
+	    get8(block, HDR_READING_VERSION) != 1 ||
+	    get8(block, HDR_NAMES_VERSION) != 1 ||
+	    get8(block, HDR_NAME_LENGTH) != NAME_LENGTH)
+		return -EPROTO;
+
+	nr = get16(block, HDR_NR_SENSORS);
+	names = get32(block, HDR_NAMES_OFFSET);
+	ping = get32(block, HDR_PING_OFFSET);
+	pong = get32(block, HDR_PONG_OFFSET);
+	if (!nr || names + nr * NAME_LENGTH > OCC_SENSORS_BLOCK_SIZE ||
+	    ping + READING_BUFFER_SIZE > OCC_SENSORS_BLOCK_SIZE ||
+	    pong + READING_BUFFER_SIZE > OCC_SENSORS_BLOCK_SIZE)
+		return -EPROTO;
+
+	return nr;
+}
+
+static size_t name_offset(const void *block, int id)
+{
+	return get32(block, HDR_NAMES_OFFSET) + id * NAME_LENGTH;
+}
+
+static int check_id(const void *block, int id)
+{
+	int nr = occ_sensors_count(block);
+
+	if (nr < 0)
+		return nr;
+	if (id < 0 || id >= nr)
+		return -EINVAL;
+	return 0;
+}
+
+static void get_string(const void *block, size_t off, char *str, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		str[i] = get8(block, off + i);
+	str[len] = '\0';
+}
+
+int occ_sensors_info(const void *block, int id, struct occ_sensor_info *info)
+{
+	size_t off;
+	int rc;
+
+	rc = check_id(block, id);
+	if (rc)
+		return rc;
+
+	off = name_offset(block, id);
+	get_string(block, off + NAME_NAME, info->name, sizeof(info->name) - 1);
+	get_string(block, off + NAME_UNITS, info->units,
+		   sizeof(info->units) - 1);
+	info->gsid = get16(block, off + NAME_GSID);
+	info->freq = get32(block, off + NAME_FREQ);
+	info->scale_factor = get32(block, off + NAME_SCALE_FACTOR);
+	info->type = get16(block, off + NAME_TYPE);
+	info->location = get16(block, off + NAME_LOCATION);
+	info->structure_type = get8(block, off + NAME_STRUCTURE_TYPE);
+
+	return 0;
+}
+
+int occ_sensors_find(const void *block, const char *name)
+{
+	struct occ_sensor_info info;
+	int i, nr;
+
+	nr = occ_sensors_count(block);
+	for (i = 0; i < nr; i++) {
+		occ_sensors_info(block, i, &info);
+		if (!strcmp(info.name, name))
+			return i;
+	}
+	return nr < 0 ? nr : -ENOENT;
+}
+
+/* Step 2: the valid buffer, or the newer one if both are */
+static const uint8_t *select_buffer(const void *block, int id)
+{
+	const uint8_t *ping, *pong;
+	uint32_t off;
+
+	ping = (const uint8_t *)block + get32(block, HDR_PING_OFFSET);
+	pong = (const uint8_t *)block + get32(block, HDR_PONG_OFFSET);
+	off = get32(block, name_offset(block, id) + NAME_READING_OFFSET);
+
+	if (get8(ping, 0) && get8(pong, 0))
+		return get64(ping, off + FULL_TIMESTAMP) >
+		       get64(pong, off + FULL_TIMESTAMP) ? ping : pong;
+	if (get8(ping, 0))
+		return ping;
+	if (get8(pong, 0))
+		return pong;
+	return NULL;
+}
+
+static int read_value(const void *block, const uint8_t *buf, int id,
+		      struct occ_sensor_value *v)
+{
+	size_t name = name_offset(block, id);
+	uint32_t off = get32(block, name + NAME_READING_OFFSET);
+
+	memset(v, 0, sizeof(*v));
+	switch (get8(block, name + NAME_STRUCTURE_TYPE)) {
+	case READING_FULL:
+		if (off + FULL_SIZE > READING_BUFFER_SIZE)
+			return -EPROTO;
+		v->timestamp = get64(buf, off + FULL_TIMESTAMP);
+		v->accumulator = get64(buf, off + FULL_ACCUMULATOR);
+		v->sample = get16(buf, off + FULL_SAMPLE);
+		v->sample_min = get16(buf, off + FULL_SAMPLE_MIN);
+		v->sample_max = get16(buf, off + FULL_SAMPLE_MAX);
+		v->csm_min = get16(buf, off + FULL_CSM_MIN);
+		v->csm_max = get16(buf, off + FULL_CSM_MAX);
+		return 0;
+	case READING_COUNTER:
+		if (off + COUNTER_SIZE > READING_BUFFER_SIZE)
+			return -EPROTO;
+		v->timestamp = get64(buf, off + COUNTER_TIMESTAMP);
+		v->accumulator = get64(buf, off + COUNTER_ACCUMULATOR);
+		v->sample = get8(buf, off + COUNTER_SAMPLE);
+		return 0;
+	default:
+		return -EPROTO;
+	}
+}
+
+int occ_sensors_snapshot(const void *block, const int *ids, int count,
+			 struct occ_sensor_value *values)
+{
+	const uint8_t *buf;
+	int i, nr, retries, rc;
+
+	/* Step 1: is the OCC running? */
+	nr = occ_sensors_count(block);
+	if (nr < 0)
+		return nr;
+	if (count <= 0)
+		return -EINVAL;
+	for (i = 0; i < count; i++)
+		if ((ids ? ids[i] : i) >= nr || (ids ? ids[i] : i) < 0)
+			return -EINVAL;
+
+	for (retries = 0; retries < SNAPSHOT_RETRIES; retries++) {
+		buf = select_buffer(block, ids ? ids[0] : 0);
+		if (!buf)
+			return -ENODATA;
+		occ_sensors_rmb();
+
+		/* Step 3: copy the readings out */
+		for (i = 0; i < count; i++) {
+			rc = read_value(block, buf, ids ? ids[i] : i,
+					&values[i]);
+			if (rc)
+				return rc;
+		}
+
+		/* Step 4: was the buffer left alone while we did? */
+		occ_sensors_rmb();
+		if (get8(buf, 0))
+			return 0;
+	}
+
+	return -EAGAIN;
+}
@@ -0,0 +1,97 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __OCC_SENSORS_H
+#define __OCC_SENSORS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Reads the OCC sensor data skiboot exports in the device tree, see
+ * doc/device-tree/ibm,occ-sensor-data.rst.
+ */
+
+#define OCC_SENSORS_MAX_OCCS		8
+#define OCC_SENSORS_BLOCK_SIZE		0x25800
+
+struct occ_sensors {
+	const uint8_t *base;
+	size_t size;
+	size_t block_size;
+	int nr_occs;
+	uint32_t chip_ids[OCC_SENSORS_MAX_OCCS];
+
+	/* What to munmap() */
+	void *map;
+	size_t map_size;
+};
+
+struct occ_sensor_info {
+	char name[17];
+	char units[5];
+	uint16_t gsid;
+	uint32_t freq;
+	uint32_t scale_factor;
+	uint16_t type;
+	uint16_t location;
+	uint8_t structure_type;
+};
+
+/* Counters only have a timestamp, accumulator and sample */
+struct occ_sensor_value {
+	uint64_t timestamp;
+	uint64_t accumulator;
+	uint16_t sample;
+	uint16_t sample_min;
+	uint16_t sample_max;
+	uint16_t csm_min;
+	uint16_t csm_max;
+};
+
+/*
+ * Map the sensor data read only, from /dev/mem at the address given in
+ * the device tree. Returns 0 or a negative errno.
+ */
+int occ_sensors_map(struct occ_sensors *s);
+
+/* Map a copy of the sensor data saved in a file, eg. for debug */
+int occ_sensors_map_file(struct occ_sensors *s, const char *path);
+
+void occ_sensors_unmap(struct occ_sensors *s);
+
+/* The block of sensor data for OCC number 'occ', or NULL */
+const void *occ_sensors_block(const struct occ_sensors *s, int occ);
+
+/* Number of sensors in a block, or a negative errno if not valid */
+int occ_sensors_count(const void *block);
+
+int occ_sensors_info(const void *block, int id, struct occ_sensor_info *info);
+
+/* Returns the id of the sensor called 'name', or -ENOENT */
+int occ_sensors_find(const void *block, const char *name);
+
+/*
+ * Read 'count' sensors of one OCC, all from the same OCC update. 'ids'
+ * lists the sensors to read, or is NULL to read sensors 0 to count - 1.
+ *
+ * Returns 0 on success, -ENODATA if the OCC has no readings available,
+ * -EAGAIN if the readings kept changing under us, -EINVAL for a bad id.
+ */
+int occ_sensors_snapshot(const void *block, const int *ids, int count,
+			 struct occ_sensor_value *values);
+
+#endif /* __OCC_SENSORS_H */
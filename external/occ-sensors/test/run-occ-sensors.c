@@ -0,0 +1,194 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Build OCC sensor data blocks the way the OCC lays them out, dump them
+ * to a file and read them back through the library, including while
+ * the OCC swaps buffers under the reader.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Lets the test play the OCC in the middle of a snapshot */
+static void (*rmb_hook)(void);
+#define occ_sensors_rmb()	do { if (rmb_hook) rmb_hook(); } while (0)
+
+#include "../occ_sensors.c"
+
+#define NR_OCCS		2
+#define NR_SENSORS	3
+#define NAMES		0x400
+#define PING		0xdc00
+#define PONG		0x18c00
+
+static uint8_t area[NR_OCCS * OCC_SENSORS_BLOCK_SIZE];
+
+static void put_be(uint8_t *p, uint64_t v, int len)
+{
+	while (len--) {
+		p[len] = v;
+		v >>= 8;
+	}
+}
+
+static uint8_t *block(int occ)
+{
+	return area + occ * OCC_SENSORS_BLOCK_SIZE;
+}
+
+static uint32_t reading_offset(int id)
+{
+	return 8 + id * FULL_SIZE;
+}
+
+static void fill(int occ, uint32_t buf, int base, uint64_t timestamp)
+{
+	uint8_t *r;
+	int i;
+
+	block(occ)[buf] = 1;
+	for (i = 0; i < NR_SENSORS; i++) {
+		r = block(occ) + buf + reading_offset(i);
+		put_be(r + FULL_TIMESTAMP, timestamp, 8);
+		/* The last sensor is a counter */
+		if (i == NR_SENSORS - 1) {
+			put_be(r + COUNTER_ACCUMULATOR, base + i, 8);
+			r[COUNTER_SAMPLE] = 1;
+			continue;
+		}
+		put_be(r + FULL_SAMPLE, base + i, 2);
+		put_be(r + FULL_SAMPLE_MAX, base + i + 50, 2);
+		put_be(r + FULL_ACCUMULATOR, 1000 + base + i, 8);
+	}
+}
+
+static void setup(void)
+{
+	static const char *names[NR_SENSORS] = { "TEMPNEST", "PWRSYS",
+						 "OCCRESET" };
+	uint8_t *b, *n;
+	int occ, i;
+
+	for (occ = 0; occ < NR_OCCS; occ++) {
+		b = block(occ);
+		b[HDR_VALID] = 1;
+		b[HDR_VERSION] = 1;
+		put_be(b + HDR_NR_SENSORS, NR_SENSORS, 2);
+		b[HDR_READING_VERSION] = 1;
+		put_be(b + HDR_NAMES_OFFSET, NAMES, 4);
+		b[HDR_NAMES_VERSION] = 1;
+		b[HDR_NAME_LENGTH] = NAME_LENGTH;
+		put_be(b + HDR_PING_OFFSET, PING, 4);
+		put_be(b + HDR_PONG_OFFSET, PONG, 4);
+		for (i = 0; i < NR_SENSORS; i++) {
+			n = b + NAMES + i * NAME_LENGTH;
+			strcpy((char *)n + NAME_NAME, names[i]);
+			memcpy(n + NAME_UNITS, "C", 1);
+			put_be(n + NAME_GSID, 0x100 + i, 2);
+			n[NAME_STRUCTURE_TYPE] = i == NR_SENSORS - 1 ?
+				READING_COUNTER : READING_FULL;
+			put_be(n + NAME_READING_OFFSET, reading_offset(i), 4);
+		}
+	}
+}
+
+static uint8_t *live;
+static int barriers;
+
+/* The OCC takes ping back to refill it, pong having just been filled */
+static void occ_swap(void)
+{
+	/* The first barrier is after picking the buffer, act on the second */
+	if (++barriers < 2)
+		return;
+	rmb_hook = NULL;
+	live[PING] = 0;
+	fill(0, PONG, 300, 40);
+}
+
+int main(void)
+{
+	char path[] = "/tmp/occ-sensors-XXXXXX";
+	struct occ_sensor_value v[NR_SENSORS];
+	struct occ_sensor_info info;
+	struct occ_sensors s;
+	const void *b0, *b1;
+	int fd, ids[2];
+
+	setup();
+	fill(0, PING, 100, 20);
+	fill(0, PONG, 200, 10);
+	fill(1, PONG, 200, 10);
+
+	fd = mkstemp(path);
+	assert(fd >= 0);
+	assert(write(fd, area, sizeof(area)) == sizeof(area));
+	close(fd);
+	assert(occ_sensors_map_file(&s, path) == 0);
+	unlink(path);
+	assert(s.nr_occs == NR_OCCS);
+	b0 = occ_sensors_block(&s, 0);
+	b1 = occ_sensors_block(&s, 1);
+	assert(!occ_sensors_block(&s, NR_OCCS));
+
+	/* Names */
+	assert(occ_sensors_count(b0) == NR_SENSORS);
+	assert(occ_sensors_info(b0, 1, &info) == 0);
+	assert(!strcmp(info.name, "PWRSYS") && !strcmp(info.units, "C"));
+	assert(info.gsid == 0x101 && info.structure_type == READING_FULL);
+	assert(occ_sensors_find(b0, "OCCRESET") == 2);
+	assert(occ_sensors_find(b0, "TEMPC0") == -ENOENT);
+	assert(occ_sensors_info(b0, NR_SENSORS, &info) == -EINVAL);
+
+	/* The newer buffer, and counters decoded as such */
+	assert(occ_sensors_snapshot(b0, NULL, NR_SENSORS, v) == 0);
+	assert(v[0].sample == 100 && v[0].sample_max == 150);
+	assert(v[0].accumulator == 1100 && v[0].timestamp == 20);
+	assert(v[2].accumulator == 102 && v[2].sample == 1);
+	assert(occ_sensors_snapshot(b1, NULL, NR_SENSORS, v) == 0);
+	assert(v[1].sample == 201);
+
+	ids[0] = 1;
+	ids[1] = NR_SENSORS;
+	assert(occ_sensors_snapshot(b0, ids, 2, v) == -EINVAL);
+	ids[1] = 0;
+	assert(occ_sensors_snapshot(b0, ids, 2, v) == 0);
+	assert(v[0].sample == 101 && v[1].sample == 100);
+	occ_sensors_unmap(&s);
+
+	/* Snapshots of the live area, with the OCC swapping buffers */
+	live = block(0);
+	rmb_hook = occ_swap;
+	assert(occ_sensors_snapshot(live, NULL, NR_SENSORS, v) == 0);
+	assert(!rmb_hook && barriers == 2);
+	assert(v[0].sample == 300 && v[1].sample == 301);
+	assert(v[0].timestamp == 40 && v[1].timestamp == 40);
+
+	/* Nothing to read */
+	live[PONG] = 0;
+	assert(occ_sensors_snapshot(live, NULL, NR_SENSORS, v) == -ENODATA);
+	live[HDR_VALID] = 0;
+	assert(occ_sensors_count(live) == -ENODATA);
+	block(1)[HDR_NAME_LENGTH] = 40;
+	assert(occ_sensors_count(block(1)) == -EPROTO);
+
+	return 0;
+}
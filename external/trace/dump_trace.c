@@ -23,6 +23,7 @@
 #include <inttypes.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #include "../../ccan/endian/endian.h"
@@ -150,17 +151,164 @@ static void dump_uart(struct trace_uart *t)
 	}
 }
 
+/*
+ * Image holding the format strings of TRACE_PRLOG entries: skiboot.lid
+ * (loaded at 0x30000000), or a dump of the region described by the
+ * ibm,opal-trace-strings property.
+ */
+static char *strings;
+static u64 strings_base = 0x30000000, strings_size;
+
+static void load_strings(const char *file)
+{
+	struct stat sb;
+	int fd;
+
+	fd = open(file, O_RDONLY);
+	if (fd < 0 || fstat(fd, &sb) < 0)
+		err(1, "Opening %s", file);
+	strings_size = sb.st_size;
+	strings = malloc(strings_size + 1);
+	if (!strings || read(fd, strings, strings_size) != strings_size)
+		err(1, "Reading %s", file);
+	strings[strings_size] = '\0';
+	close(fd);
+}
+
+static const char *lookup_string(u64 addr)
+{
+	if (!strings || addr < strings_base ||
+	    addr >= strings_base + strings_size)
+		return NULL;
+	return strings + (addr - strings_base);
+}
+
+static bool prlog_arg(struct trace_prlog *t, unsigned int *pos,
+		      unsigned int *n, u64 *v, const char **str)
+{
+	unsigned int len = t->hdr.len_div_8 * 8 - offsetof(struct trace_prlog, data);
+	__be64 bev;
+
+	if (*n >= t->nargs || *pos >= len)
+		return false;
+
+	*str = NULL;
+	if (be16_to_cpu(t->str_mask) & (1 << *n)) {
+		*str = (const char *)&t->data[*pos];
+		*pos += (strnlen(*str, len - *pos) + 8) & ~7;
+	} else {
+		memcpy(&bev, &t->data[*pos], sizeof(bev));
+		*v = be64_to_cpu(bev);
+		*pos += sizeof(bev);
+	}
+	(*n)++;
+	return true;
+}
+
+static void dump_prlog(struct trace_prlog *t)
+{
+	const char *fmt, *p, *str;
+	unsigned int pos = 0, n = 0;
+	char spec[64];
+	size_t slen;
+	u64 v;
+
+	printf("PRLOG <%d> ", t->level);
+	fmt = lookup_string(be64_to_cpu(t->fmt));
+	if (!fmt) {
+		printf("fmt=0x%016"PRIx64" nargs=%u\n",
+		       be64_to_cpu(t->fmt), t->nargs);
+		return;
+	}
+
+	for (p = fmt; *p; p++) {
+		if (*p != '%' || p[1] == '%') {
+			if (*p == '%')
+				p++;
+			putchar(*p);
+			continue;
+		}
+
+		/* Rebuild the conversion with '*' resolved and a 64-bit size */
+		slen = 0;
+		spec[slen++] = *p++;
+		for (; *p && strchr("-+ #0123456789.*", *p); p++) {
+			if (*p != '*') {
+				if (slen < 32)
+					spec[slen++] = *p;
+				continue;
+			}
+			if (!prlog_arg(t, &pos, &n, &v, &str))
+				goto truncated;
+			slen += snprintf(spec + slen, sizeof(spec) - slen,
+					 "%d", (int)v);
+		}
+		for (; *p && strchr("hlLqjzt", *p); p++)
+			;
+		if (!*p || !prlog_arg(t, &pos, &n, &v, &str))
+			goto truncated;
+
+		switch (*p) {
+		case 's':
+			spec[slen++] = 's';
+			spec[slen] = '\0';
+			if (!str)
+				str = lookup_string(v);
+			printf(spec, str ? str : "(?)");
+			break;
+		case 'p':
+			printf("%p", (void *)(uintptr_t)v);
+			break;
+		case 'c':
+			spec[slen++] = 'c';
+			spec[slen] = '\0';
+			printf(spec, (int)v);
+			break;
+		default:
+			spec[slen++] = 'l';
+			spec[slen++] = 'l';
+			spec[slen++] = *p;
+			spec[slen] = '\0';
+			printf(spec, (unsigned long long)v);
+		}
+	}
+	if (p > fmt && p[-1] != '\n')
+		putchar('\n');
+	return;
+
+truncated:
+	printf(" [bad record]\n");
+}
+
+static void usage(void)
+{
+	errx(1, "Usage: dump_trace [-s skiboot.lid [-b base]] [file]");
+}
+
 int main(int argc, char *argv[])
 {
-	int fd, len = 0;
+	int fd, len = 0, opt;
 	union trace t;
 	const char *in = "/sys/kernel/debug/powerpc/opal-trace";
 
-	if (argc > 2)
-		errx(1, "Usage: dump_trace [file]");
+	while ((opt = getopt(argc, argv, "s:b:")) != -1) {
+		switch (opt) {
+		case 's':
+			load_strings(optarg);
+			break;
+		case 'b':
+			strings_base = strtoull(optarg, NULL, 0);
+			break;
+		default:
+			usage();
+		}
+	}
+
+	if (argc - optind > 1)
+		usage();
 
-	if (argv[1])
-		in = argv[1];
+	if (optind < argc)
+		in = argv[optind];
 	fd = open(in, O_RDONLY);
 	if (fd < 0)
 		err(1, "Opening %s", in);
@@ -188,6 +336,9 @@ int main(int argc, char *argv[])
 		case TRACE_UART:
 			dump_uart(&t.uart);
 			break;
+		case TRACE_PRLOG:
+			dump_prlog(&t.prlog);
+			break;
 		default:
 			printf("UNKNOWN(%u) CPU %u length %u\n",
 			       t.hdr.type, be16_to_cpu(t.hdr.cpu),
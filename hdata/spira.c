@@ -24,6 +24,7 @@
 #include <fsp-mdst-table.h>
 #include <fsp-attn.h>
 #include <fsp-leds.h>
+#include <bootprof.h>
 
 #include "hdata.h"
 #include "hostservices.h"
@@ -295,7 +296,14 @@ struct dt_node *find_xscom_for_chip(uint32_t chip_id)
 	struct dt_node *node;
 	uint32_t id;
 
-	dt_for_each_compatible(dt_root, node, "ibm,xscom") {
+	/*
+	 * XSCOM nodes all sit under the root, only look there: this is
+	 * called for each chip by most parsing steps and walking the
+	 * whole tree every time adds up on big machines.
+	 */
+	dt_for_each_child(dt_root, node) {
+		if (!dt_node_is_compatible(node, "ibm,xscom"))
+			continue;
 		id = dt_get_chip_id(node);
 		if (id == chip_id)
 			return node;
@@ -1263,6 +1271,7 @@ int parse_hdat(bool is_opal)
 
 	prlog(PR_DEBUG, "Parsing HDAT...\n");
 
+	bootprof_phase("hdat_fixup_spira");
 	fixup_spira();
 
 	/*
@@ -1273,6 +1282,7 @@ int parse_hdat(bool is_opal)
 	dt_add_property_string(dt_root, "lid-type", is_opal ? "opal" : "phyp");
 
 	/* Add any BMCs and enable the LPC UART */
+	bootprof_phase("hdat_bmc");
 	bmc_parse();
 
 	/* Create /vpd node */
@@ -1282,44 +1292,56 @@ int parse_hdat(bool is_opal)
 	dt_init_led_node();
 
 	/* Parse SPPACA and/or PCIA */
+	bootprof_phase("hdat_cpus");
 	if (!pcia_parse())
 		if (paca_parse() < 0)
 			return -1;
 
 	/* IPL params */
+	bootprof_phase("hdat_iplparams");
 	add_iplparams();
 
 	/* Parse MS VPD */
+	bootprof_phase("hdat_memory");
 	memory_parse();
 
 	/* Add XSCOM node (must be before chiptod, IO and FSP) */
+	bootprof_phase("hdat_xscom");
 	add_xscom();
 
 	/* Add any FSPs */
+	bootprof_phase("hdat_fsp");
 	fsp_parse();
 
 	/* Add ChipTOD's */
+	bootprof_phase("hdat_chiptod");
 	if (!add_chiptod_old() && !add_chiptod_new())
 		prerror("CHIPTOD: No ChipTOD found !\n");
 
 	/* Add NX */
+	bootprof_phase("hdat_nx");
 	add_nx();
 
 	/* Add nest mmu */
 	add_nmmu();
 
 	/* Add IO HUBs and/or PHBs */
+	bootprof_phase("hdat_io");
 	io_parse();
 
 	/* Parse VPD */
+	bootprof_phase("hdat_vpd");
 	vpd_parse();
 
 	/* Host services information. */
+	bootprof_phase("hdat_hostservices");
  	hostservices_parse();
 
 	/* Parse System Attention Indicator inforamtion */
+	bootprof_phase("hdat_sai");
 	slca_dt_add_sai_node();
 
+	bootprof_phase("hdat_stop_levels");
 	add_stop_levels();
 
 	prlog(PR_DEBUG, "Parsing HDAT...done\n");
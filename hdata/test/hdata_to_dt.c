@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <time.h>
 #include <mem_region-malloc.h>
 
 #include <interrupts.h>
@@ -51,8 +52,19 @@ static void *ntuple_addr(const struct spira_ntuple *n);
 
 unsigned long tb_hz = 512000000;
 
+/* Fake a timebase from the host clock, for timing the parser with -t */
+#define __TEST__
+static inline unsigned long mftb(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * tb_hz + ts.tv_nsec * (tb_hz / 1000000) / 1000;
+}
+
 /* Don't include processor-specific stuff. */
 #define __PROCESSOR_H
+static inline void lwsync(void) { }
 /* PVR bits */
 #define SPR_PVR_TYPE			0xffff0000
 #define SPR_PVR_VERS_MAJ		0x00000f00
@@ -131,6 +143,8 @@ static bool spira_check_ptr(const void *ptr, const char *file, unsigned int line
 #include "../../core/fdt.c"
 #include "../../hw/phys-map.c"
 #include "../../core/mem_region.c"
+#undef pr_fmt
+#include "../../core/bootprof.c"
 
 #include <err.h>
 
@@ -233,10 +247,35 @@ static void dump_hdata_fdt(struct dt_node *root)
 	free(fdt_blob);
 }
 
+static void print_hdat_steps(void)
+{
+	unsigned long total = 0;
+	struct dt_node *n;
+	unsigned int i, nodes = 0;
+
+	dt_for_each_node(dt_root, n)
+		nodes++;
+
+	/* parse_hdat() records each step as a boot profile phase */
+	printf("%-20s %10s\n", "step", "time(us)");
+	for (i = 0; i < be32_to_cpu(bootprof.hdr.nr_entries); i++) {
+		struct bootprof_entry *e = &bootprof.entries[i];
+		unsigned long t = be64_to_cpu(e->end) - be64_to_cpu(e->start);
+
+		if (e->type != BOOTPROF_PHASE)
+			continue;
+		printf("%-20s %10lu\n", e->name, tb_to_usecs(t));
+		total += t;
+	}
+	printf("%-20s %10lu (%u nodes)\n", "total", tb_to_usecs(total),
+	       nodes);
+}
+
 int main(int argc, char *argv[])
 {
 	int fd, r, i = 0, opt_count = 0;
 	bool verbose = false, quiet = false, new_spira = false, blobs = false;
+	bool timing = false;
 
 	while (argv[++i]) {
 		if (strcmp(argv[i], "-v") == 0) {
@@ -251,6 +290,9 @@ int main(int argc, char *argv[])
 		} else if (strcmp(argv[i], "-b") == 0) {
 			blobs = true;
 			opt_count++;
+		} else if (strcmp(argv[i], "-t") == 0) {
+			timing = true;
+			opt_count++;
 		} else if (strcmp(argv[i], "-7") == 0) {
 			fake_pvr = PVR_P7;
 			proc_gen = proc_gen_p7;
@@ -282,6 +324,8 @@ int main(int argc, char *argv[])
 		     "	-v Verbose\n"
 		     "	-q Quiet mode\n"
 		     "	-b Keep blobs in the output\n"
+		     "	-t Print the time taken by each parsing step\n"
+		     "	   instead of the DTB\n"
 		     "\n"
 		     "  -7 Force PVR to POWER7\n"
 		     "  -8 Force PVR to POWER8\n"
@@ -349,16 +393,22 @@ int main(int argc, char *argv[])
 		spiras = (struct spiras *)spira_heap;
 
 	if (quiet) {
-		fclose(stdout);
+		if (!timing)
+			fclose(stdout);
 		fclose(stderr);
 	}
 
 	dt_root = dt_new_root("");
 
+	bootprof_reset();
 	if(parse_hdat(false) < 0) {
 		fprintf(stderr, "FATAL ERROR parsing HDAT\n");
 		exit(EXIT_FAILURE);
 	}
+	bootprof_phase(NULL);
+
+	if (timing)
+		print_hdat_steps();
 
 	mem_region_init();
 	mem_region_release_unused();
@@ -366,7 +416,7 @@ int main(int argc, char *argv[])
 	if (!blobs)
 		squash_blobs(dt_root);
 
-	if (!quiet)
+	if (!quiet && !timing)
 		dump_hdata_fdt(dt_root);
 
 	dt_free(dt_root);
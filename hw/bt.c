@@ -28,6 +28,8 @@
 #include <timebase.h>
 #include <chip.h>
 #include <interrupts.h>
+#include <nvram.h>
+#include <pool.h>
 
 /* BT registers */
 #define BT_CTRL			0
@@ -70,6 +72,16 @@
 /* Maximum number of times to attempt sending a message before giving up. */
 #define BT_MAX_RETRIES		1
 
+/*
+ * Maximum number of messages handed to the BMC before their responses
+ * come back, if it says it can take that many (and NVRAM "bt-window"
+ * doesn't say otherwise). Responses are matched up by sequence number.
+ */
+#define BT_MAX_WINDOW		4
+
+/* Length byte + netfn + seq + cmd + up to 255 bytes of data */
+#define BT_MAX_MSG_LEN		(BT_MIN_REQ_LEN + 1 + 255)
+
 /* Macro to enable printing BT message queue for debug */
 #define BT_QUEUE_DEBUG		0
 
@@ -96,9 +108,28 @@ struct bt_msg {
 	unsigned long tb;
 	uint8_t seq;
 	uint8_t send_count;
+	struct bt_msg_pool *pool;	/* NULL if from the heap */
 	struct ipmi_msg ipmi_msg;
 };
 
+/*
+ * Messages come out of fixed size pools with the data buffer inline,
+ * smallest first, as most of our traffic (SEL, sensors, watchdog) only
+ * carries a few bytes. Anything bigger, or anything once its pool has
+ * run dry, comes from the heap.
+ */
+static struct bt_msg_pool {
+	struct pool pool;
+	size_t data_len;
+	int count;
+	bool ready;
+} bt_msg_pools[] = {
+	{ .data_len = 16, .count = 32 },
+	{ .data_len = MAX(IPMI_MAX_REQ_SIZE, IPMI_MAX_RESP_SIZE), .count = 16 },
+};
+
+static struct lock bt_msg_pool_lock = LOCK_UNLOCKED;
+
 struct bt_caps {
 	uint8_t num_requests;
 	uint16_t input_buf_len;
@@ -114,6 +145,9 @@ struct bt {
 	struct timer poller;
 	bool irq_ok;
 	int queue_len;
+	int inflight;		/* Sent, waiting for a response */
+	int window;		/* Our limit on inflight */
+	struct bt_msg *last_sent; /* Whose request is in the FIFO */
 	struct bt_caps caps;
 };
 
@@ -131,6 +165,17 @@ static inline void bt_outb(uint8_t data, uint32_t reg)
 	lpc_outb(data, bt.base_addr + reg);
 }
 
+static inline void bt_read_fifo(void *buf, uint32_t len)
+{
+	if (lpc_read_fifo(OPAL_LPC_IO, bt.base_addr + BT_HOST2BMC, buf, len))
+		memset(buf, 0xff, len);
+}
+
+static inline void bt_write_fifo(const void *buf, uint32_t len)
+{
+	lpc_write_fifo(OPAL_LPC_IO, bt.base_addr + BT_HOST2BMC, buf, len);
+}
+
 static inline void bt_set_h_busy(bool value)
 {
 	uint8_t rval;
@@ -212,11 +257,26 @@ static inline bool bt_idle(void)
 	return !(bt_ctrl & BT_CTRL_B_BUSY) && !(bt_ctrl & BT_CTRL_H2B_ATN);
 }
 
+static int bt_window(void)
+{
+	return MAX(1, MIN(bt.window, bt.caps.num_requests));
+}
+
 /* Must be called with bt.lock held */
-static void bt_msg_del(struct bt_msg *bt_msg)
+static void bt_msg_unlink(struct bt_msg *bt_msg)
 {
 	list_del(&bt_msg->link);
 	bt.queue_len--;
+	if (bt_msg->send_count)
+		bt.inflight--;
+	if (bt.last_sent == bt_msg)
+		bt.last_sent = NULL;
+}
+
+/* Must be called with bt.lock held */
+static void bt_msg_del(struct bt_msg *bt_msg)
+{
+	bt_msg_unlink(bt_msg);
 	unlock(&bt.lock);
 	ipmi_cmd_done(bt_msg->ipmi_msg.cmd,
 		      IPMI_NETFN_RETURN_CODE(bt_msg->ipmi_msg.netfn),
@@ -246,32 +306,36 @@ static void bt_reset_interface(void)
  */
 static void bt_send_msg(struct bt_msg *bt_msg)
 {
-	int i;
 	struct ipmi_msg *ipmi_msg;
+	uint8_t buf[BT_MAX_MSG_LEN];
 
 	ipmi_msg = &bt_msg->ipmi_msg;
-
-	/* Send the message */
-	bt_outb(BT_CTRL_CLR_WR_PTR, BT_CTRL);
+	assert(ipmi_msg->req_size <= BT_MAX_MSG_LEN - BT_MIN_REQ_LEN - 1);
 
 	/* Byte 1 - Length */
-	bt_outb(ipmi_msg->req_size + BT_MIN_REQ_LEN, BT_HOST2BMC);
+	buf[0] = ipmi_msg->req_size + BT_MIN_REQ_LEN;
 
 	/* Byte 2 - NetFn/LUN */
-	bt_outb(ipmi_msg->netfn, BT_HOST2BMC);
+	buf[1] = ipmi_msg->netfn;
 
 	/* Byte 3 - Seq */
-	bt_outb(bt_msg->seq, BT_HOST2BMC);
+	buf[2] = bt_msg->seq;
 
 	/* Byte 4 - Cmd */
-	bt_outb(ipmi_msg->cmd, BT_HOST2BMC);
+	buf[3] = ipmi_msg->cmd;
 
 	/* Byte 5:N - Data */
-	for (i = 0; i < ipmi_msg->req_size; i++)
-		bt_outb(ipmi_msg->data[i], BT_HOST2BMC);
+	memcpy(&buf[4], ipmi_msg->data, ipmi_msg->req_size);
+
+	/* Send the message */
+	bt_outb(BT_CTRL_CLR_WR_PTR, BT_CTRL);
+	bt_write_fifo(buf, ipmi_msg->req_size + BT_MIN_REQ_LEN + 1);
 
 	BT_Q_DBG(bt_msg, "Message sent to host");
+	if (!bt_msg->send_count)
+		bt.inflight++;
 	bt_msg->send_count++;
+	bt.last_sent = bt_msg;
 
 	bt_outb(BT_CTRL_H2B_ATN, BT_CTRL);
 
@@ -298,9 +362,9 @@ static void bt_flush_msg(void)
 
 static void bt_get_resp(void)
 {
-	int i;
 	struct bt_msg *tmp_bt_msg, *bt_msg = NULL;
 	struct ipmi_msg *ipmi_msg;
+	uint8_t hdr[BT_MIN_RESP_LEN + 1];
 	uint8_t resp_len, netfn, seq, cmd;
 	uint8_t cc = IPMI_CC_NO_ERROR;
 
@@ -311,25 +375,27 @@ static void bt_get_resp(void)
 	bt_outb(BT_CTRL_B2H_ATN, BT_CTRL);
 	bt_outb(BT_CTRL_CLR_RD_PTR, BT_CTRL);
 
-	/* Read the response */
+	/* Read the response header */
+	bt_read_fifo(hdr, sizeof(hdr));
+
 	/* Byte 1 - Length (includes header size) */
-	resp_len = bt_inb(BT_HOST2BMC) - BT_MIN_RESP_LEN;
+	resp_len = hdr[0] - BT_MIN_RESP_LEN;
 
 	/* Byte 2 - NetFn/LUN */
-	netfn = bt_inb(BT_HOST2BMC);
+	netfn = hdr[1];
 
 	/* Byte 3 - Seq */
-	seq = bt_inb(BT_HOST2BMC);
+	seq = hdr[2];
 
 	/* Byte 4 - Cmd */
-	cmd = bt_inb(BT_HOST2BMC);
+	cmd = hdr[3];
 
 	/* Byte 5 - Completion Code */
-	cc = bt_inb(BT_HOST2BMC);
+	cc = hdr[4];
 
-	/* Find the corresponding message */
+	/* Find the corresponding message, any of the ones in flight */
 	list_for_each(&bt.msgq, tmp_bt_msg, link) {
-		if (tmp_bt_msg->seq == seq) {
+		if (tmp_bt_msg->send_count && tmp_bt_msg->seq == seq) {
 			bt_msg = tmp_bt_msg;
 			break;
 		}
@@ -358,14 +424,12 @@ static void bt_get_resp(void)
 	ipmi_msg->resp_size = resp_len;
 
 	/* Byte 6:N - Data */
-	for (i = 0; i < resp_len; i++)
-		ipmi_msg->data[i] = bt_inb(BT_HOST2BMC);
+	bt_read_fifo(ipmi_msg->data, resp_len);
 	bt_set_h_busy(false);
 
 	BT_Q_DBG(bt_msg, "IPMI MSG done");
 
-	list_del(&bt_msg->link);
-	bt.queue_len--;
+	bt_msg_unlink(bt_msg);
 	unlock(&bt.lock);
 
 	/* Call IPMI layer to finish processing the message. */
@@ -377,23 +441,58 @@ static void bt_get_resp(void)
 
 static void bt_expire_old_msg(uint64_t tb)
 {
-	struct bt_msg *bt_msg;
+	struct bt_msg *bt_msg, *next;
+
+	if (chip_quirk(QUIRK_SIMICS))
+		return;
 
-	bt_msg = list_top(&bt.msgq, struct bt_msg, link);
+	list_for_each_safe(&bt.msgq, bt_msg, next, link) {
+		if (bt_msg->tb == 0 ||
+		    tb_compare(tb, bt_msg->tb +
+			       secs_to_tb(bt.caps.msg_timeout)) != TB_AAFTERB)
+			continue;
+
+		/*
+		 * The top message never made it into the FIFO, so there's
+		 * nothing to retry and it isn't counted in bt.inflight.
+		 * If it's waiting on the window, the messages holding it
+		 * open have timeouts of their own. Otherwise the BMC
+		 * hasn't let go of the interface for a whole timeout, so
+		 * give up on it.
+		 */
+		if (!bt_msg->send_count) {
+			if (bt.inflight >= bt_window()) {
+				bt_msg->tb = tb;
+				continue;
+			}
+			BT_Q_ERR(bt_msg, "Timeout waiting to send message");
+			bt_msg_del(bt_msg);
+			bt_reset_interface();
+			break;
+		}
 
-	if (bt_msg && bt_msg->tb > 0 && !chip_quirk(QUIRK_SIMICS) &&
-	    (tb_compare(tb, bt_msg->tb +
-			secs_to_tb(bt.caps.msg_timeout)) == TB_AAFTERB)) {
 		if (bt_msg->send_count <= bt.caps.max_retries) {
+			BT_Q_ERR(bt_msg, "Retry sending message");
+			bt_msg->tb = tb;
+
+			/*
+			 * Another message went through the FIFO since,
+			 * send this one again. It's already counted in
+			 * bt.inflight, so this doesn't open the window
+			 * any further.
+			 */
+			if (bt_msg != bt.last_sent && bt_idle()) {
+				bt_send_msg(bt_msg);
+				continue;
+			}
+
 			/* A message timeout is usually due to the BMC
 			 * clearing the H2B_ATN flag without actually
 			 * doing anything. The data will still be in the
 			 * FIFO so just reset the flag.*/
-			BT_Q_ERR(bt_msg, "Retry sending message");
 			bt_msg->send_count++;
-
-			bt_msg->tb = tb;
-			bt_outb(BT_CTRL_H2B_ATN, BT_CTRL);
+			if (bt_msg == bt.last_sent)
+				bt_outb(BT_CTRL_H2B_ATN, BT_CTRL);
 		} else {
 			BT_Q_ERR(bt_msg, "Timeout sending message");
 			bt_msg_del(bt_msg);
@@ -405,6 +504,9 @@ static void bt_expire_old_msg(uint64_t tb)
 			 * sufficient to guard against such things.
 			 */
 			bt_reset_interface();
+
+			/* The queue may have changed while unlocked */
+			break;
 		}
 	}
 }
@@ -447,12 +549,22 @@ static void bt_send_and_unlock(void)
 			bt_msg->tb = mftb();
 
 		/*
-		 * Only send it if we haven't already.
-		 * Timeouts and retries happen in bt_expire_old_msg()
-		 * called from bt_poll()
+		 * Send the first message we haven't sent yet, if the
+		 * window has room. The FIFO holds one request at a
+		 * time so that's all we can do until the BMC has
+		 * picked it up. Timeouts and retries happen in
+		 * bt_expire_old_msg() called from bt_poll()
 		 */
-		if (bt_idle() && bt_msg->send_count == 0)
-			bt_send_msg(bt_msg);
+		if (bt.inflight < bt_window() && bt_idle()) {
+			list_for_each(&bt.msgq, bt_msg, link) {
+				if (bt_msg->send_count)
+					continue;
+				if (bt_msg->tb == 0)
+					bt_msg->tb = mftb();
+				bt_send_msg(bt_msg);
+				break;
+			}
+		}
 	}
 
 	unlock(&bt.lock);
@@ -563,9 +675,27 @@ static void bt_irq(uint32_t chip_id __unused, uint32_t irq_mask __unused)
  */
 static struct ipmi_msg *bt_alloc_ipmi_msg(size_t request_size, size_t response_size)
 {
-	struct bt_msg *bt_msg;
+	size_t size = MAX(request_size, response_size);
+	struct bt_msg_pool *p;
+	struct bt_msg *bt_msg = NULL;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bt_msg_pools); i++) {
+		p = &bt_msg_pools[i];
+		if (!p->ready || size > p->data_len)
+			continue;
 
-	bt_msg = zalloc(sizeof(struct bt_msg) + MAX(request_size, response_size));
+		lock(&bt_msg_pool_lock);
+		bt_msg = pool_get(&p->pool, POOL_NORMAL);
+		unlock(&bt_msg_pool_lock);
+		if (bt_msg) {
+			bt_msg->pool = p;
+			break;
+		}
+	}
+
+	if (!bt_msg)
+		bt_msg = zalloc(sizeof(struct bt_msg) + size);
 	if (!bt_msg)
 		return NULL;
 
@@ -583,7 +713,32 @@ static void bt_free_ipmi_msg(struct ipmi_msg *ipmi_msg)
 {
 	struct bt_msg *bt_msg = container_of(ipmi_msg, struct bt_msg, ipmi_msg);
 
-	free(bt_msg);
+	if (!bt_msg->pool) {
+		free(bt_msg);
+		return;
+	}
+
+	lock(&bt_msg_pool_lock);
+	pool_free_object(&bt_msg->pool->pool, bt_msg);
+	unlock(&bt_msg_pool_lock);
+}
+
+static void bt_init_msg_pools(void)
+{
+	struct bt_msg_pool *p;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bt_msg_pools); i++) {
+		p = &bt_msg_pools[i];
+		/* Keep the objects after the first one 8 byte aligned */
+		if (pool_init(&p->pool,
+			      ALIGN_UP(sizeof(struct bt_msg) + p->data_len, 8),
+			      p->count, 0))
+			prerror("Failed to allocate %zd byte message pool\n",
+				p->data_len);
+		else
+			p->ready = true;
+	}
 }
 
 /*
@@ -596,8 +751,7 @@ static int bt_del_ipmi_msg(struct ipmi_msg *ipmi_msg)
 	struct bt_msg *bt_msg = container_of(ipmi_msg, struct bt_msg, ipmi_msg);
 
 	lock(&bt.lock);
-	list_del_from(&bt.msgq, &bt_msg->link);
-	bt.queue_len--;
+	bt_msg_unlink(bt_msg);
 	bt_send_and_unlock();
 	return 0;
 }
@@ -626,6 +780,7 @@ void bt_init(void)
 	bt.caps.output_buf_len = BT_FIFO_LEN;
 	bt.caps.msg_timeout = BT_MSG_TIMEOUT;
 	bt.caps.max_retries = BT_MAX_RETRIES;
+	bt.window = BT_MAX_WINDOW;
 
 	/* We support only one */
 	n = dt_find_compatible_node(dt_root, NULL, "ipmi-bt");
@@ -656,6 +811,8 @@ void bt_init(void)
 	 */
 	list_head_init(&bt.msgq);
 	bt.queue_len = 0;
+	bt.inflight = 0;
+	bt_init_msg_pools();
 
 	prlog(PR_NOTICE, "Interface initialized, IO 0x%04x\n", bt.base_addr);
 
@@ -678,3 +835,22 @@ void bt_init(void)
 
 	prlog(PR_DEBUG, "Using LPC IRQ %d\n", irq);
 }
+
+void bt_nvram_init(void)
+{
+	const char *s;
+
+	if (!bt.base_addr)
+		return;
+
+	s = nvram_query("bt-window");
+	if (!s)
+		return;
+
+	/* Sequence numbers are a byte, can't tell more than that apart */
+	lock(&bt.lock);
+	bt.window = MAX(1, MIN(atoi(s), 255));
+	unlock(&bt.lock);
+	prlog(PR_NOTICE, "NVRAM set window to %d (BMC supports %d)\n",
+	      bt.window, bt.caps.num_requests);
+}
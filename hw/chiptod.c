@@ -26,6 +26,7 @@
 #include <io.h>
 #include <cpu.h>
 #include <timebase.h>
+#include <bootprof.h>
 #include <opal-api.h>
 
 /* TOD chip XSCOM addresses */
@@ -773,6 +774,24 @@ static void chiptod_reset_tod_errors(void)
 	}
 }
 
+/*
+ * The boot profile runs off the boot CPU's timebase, so tell it when
+ * that one is about to be reset and once it's running again. Only the
+ * jump itself is taken out of the profile, the rest of the sync is
+ * still timed.
+ */
+static void chiptod_tb_reset_begin(void)
+{
+	if (this_cpu() == boot_cpu)
+		bootprof_tb_reset_begin();
+}
+
+static void chiptod_tb_reset_end(void)
+{
+	if (this_cpu() == boot_cpu)
+		bootprof_tb_reset_end();
+}
+
 static void chiptod_sync_master(void *data)
 {
 	bool *result = data;
@@ -795,6 +814,7 @@ static void chiptod_sync_master(void *data)
 	chiptod_reset_tod_errors();
 
 	/* Switch timebase to "Not Set" state */
+	chiptod_tb_reset_begin();
 	if (!chiptod_mod_tb())
 		goto error;
 	prlog(PR_INSANE, "SYNC MASTER Step 2 TFMR=0x%016lx\n", mfspr(SPR_TFMR));
@@ -850,6 +870,7 @@ static void chiptod_sync_master(void *data)
 	/* Check if TB is running */
 	if (!chiptod_check_tb_running())
 		goto error;
+	chiptod_tb_reset_end();
 
 	prlog(PR_INSANE, "Master sync completed, TB=%lx\n", mfspr(SPR_TBRL));
 
@@ -865,6 +886,7 @@ static void chiptod_sync_master(void *data)
 	*result = true;
 	return;
  error:
+	chiptod_tb_reset_end();
 	prerror("Master sync failed! TFMR=0x%016lx\n", mfspr(SPR_TFMR));
 	*result = false;
 }
@@ -896,6 +918,7 @@ static void chiptod_sync_slave(void *data)
 	chiptod_cleanup_thread_tfmr();
 
 	/* Switch timebase to "Not Set" state */
+	chiptod_tb_reset_begin();
 	if (!chiptod_mod_tb())
 		goto error;
 	prlog(PR_INSANE, "SYNC SLAVE Step 2 TFMR=0x%016lx\n", mfspr(SPR_TFMR));
@@ -918,12 +941,14 @@ static void chiptod_sync_slave(void *data)
 	/* Check if TB is running */
 	if (!chiptod_check_tb_running())
 		goto error;
+	chiptod_tb_reset_end();
 
 	prlog(PR_INSANE, "Slave sync completed, TB=%lx\n", mfspr(SPR_TBRL));
 
 	*result = true;
 	return;
  error:
+	chiptod_tb_reset_end();
 	prerror("Slave sync failed ! TFMR=0x%016lx\n", mfspr(SPR_TFMR));
 	*result = false;
 }
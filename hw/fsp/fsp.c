@@ -37,6 +37,7 @@
 #include <errorlog.h>
 #include <opal.h>
 #include <opal-msg.h>
+#include <pool.h>
 #include <ccan/list/list.h>
 
 DEFINE_LOG_ENTRY(OPAL_RC_FSP_POLL_TIMEOUT, OPAL_PLATFORM_ERR_EVT, OPAL_FSP,
@@ -138,10 +139,18 @@ void fsp_handle_resp(struct fsp_msg *msg);
 struct fsp_cmdclass {
 	int timeout;
 	bool busy;
+	bool critical;			/* Serviced ahead of the others */
 	struct list_head msgq;
 	struct list_head clientq;
 	struct list_head rr_queue;	/* To queue up msgs during R/R */
 	u64 timesent;
+
+	/* Statistics */
+	unsigned int depth;		/* Queued or in flight */
+	unsigned int max_depth;
+	u64 nr_complete;
+	u64 lat_total;			/* Queue to completion, in tb */
+	u64 lat_max;
 };
 
 static struct fsp_cmdclass fsp_cmdclass_rr;
@@ -149,15 +158,17 @@ static struct fsp_cmdclass fsp_cmdclass_rr;
 static struct fsp_cmdclass fsp_cmdclass[FSP_MCLASS_LAST - FSP_MCLASS_FIRST + 1]
 = {
 #define DEF_CLASS(_cl, _to) [_cl - FSP_MCLASS_FIRST] = { .timeout = _to }
-	DEF_CLASS(FSP_MCLASS_SERVICE,		16),
+#define DEF_CRIT_CLASS(_cl, _to) [_cl - FSP_MCLASS_FIRST] = \
+	{ .timeout = _to, .critical = true }
+	DEF_CRIT_CLASS(FSP_MCLASS_SERVICE,	16),
 	DEF_CLASS(FSP_MCLASS_PCTRL_MSG,		16),
-	DEF_CLASS(FSP_MCLASS_PCTRL_ABORTS,	16),
+	DEF_CRIT_CLASS(FSP_MCLASS_PCTRL_ABORTS,	16),
 	DEF_CLASS(FSP_MCLASS_ERR_LOG,		16),
 	DEF_CLASS(FSP_MCLASS_CODE_UPDATE,	40),
 	DEF_CLASS(FSP_MCLASS_FETCH_SPDATA,	16),
 	DEF_CLASS(FSP_MCLASS_FETCH_HVDATA,	16),
 	DEF_CLASS(FSP_MCLASS_NVRAM,		16),
-	DEF_CLASS(FSP_MCLASS_MBOX_SURV,		 2),
+	DEF_CRIT_CLASS(FSP_MCLASS_MBOX_SURV,	 2),
 	DEF_CLASS(FSP_MCLASS_RTC,		16),
 	DEF_CLASS(FSP_MCLASS_SMART_CHIP,	20),
 	DEF_CLASS(FSP_MCLASS_INDICATOR,	       180),
@@ -243,22 +254,50 @@ static struct fsp_cmdclass *fsp_get_cmdclass(struct fsp_msg *msg)
 	return __fsp_get_cmdclass(c);
 }
 
+/*
+ * Messages come out of a preallocated pool so the common path doesn't
+ * go through the heap. The driver's own allocations (incoming commands
+ * and responses, which can't be retried) may dip into the reserve. If
+ * the pool runs dry we fall back to the heap.
+ */
+#define FSP_MSG_POOL_SIZE	256
+#define FSP_MSG_POOL_RESERVED	32
+
+static struct pool fsp_msg_pool;
+static struct lock fsp_msg_pool_lock = LOCK_UNLOCKED;
+static bool fsp_msg_pool_ready;
+
+static struct fsp_msg *fsp_pool_allocmsg(enum pool_priority prio)
+{
+	struct fsp_msg *msg = NULL;
+
+	if (fsp_msg_pool_ready) {
+		lock(&fsp_msg_pool_lock);
+		msg = pool_get(&fsp_msg_pool, prio);
+		unlock(&fsp_msg_pool_lock);
+	}
+	if (!msg)
+		msg = zalloc(sizeof(struct fsp_msg));
+
+	return msg;
+}
+
 static struct fsp_msg *__fsp_allocmsg(void)
 {
-	return zalloc(sizeof(struct fsp_msg));
+	return fsp_pool_allocmsg(POOL_HIGH);
 }
 
 struct fsp_msg *fsp_allocmsg(bool alloc_response)
 {
 	struct fsp_msg *msg;
 
-	msg = __fsp_allocmsg();
+	msg = fsp_pool_allocmsg(POOL_NORMAL);
 	if (!msg)
 		return NULL;
 	if (alloc_response) {
-		msg->resp = __fsp_allocmsg();
+		msg->resp = fsp_pool_allocmsg(POOL_NORMAL);
 		if (!msg->resp) {
-			free(msg);
+			__fsp_freemsg(msg);
 			return NULL;
 		}
 	}
@@ -266,9 +305,25 @@ struct fsp_msg *fsp_allocmsg(bool alloc_response)
 	return msg;
 }
 
+static bool fsp_msg_from_pool(struct fsp_msg *msg)
+{
+	void *p = msg;
+
+	return fsp_msg_pool_ready && p >= fsp_msg_pool.buf &&
+		p < fsp_msg_pool.buf +
+		    fsp_msg_pool.obj_size * FSP_MSG_POOL_SIZE;
+}
+
 void __fsp_freemsg(struct fsp_msg *msg)
 {
-	free(msg);
+	if (!fsp_msg_from_pool(msg)) {
+		free(msg);
+		return;
+	}
+
+	lock(&fsp_msg_pool_lock);
+	pool_free_object(&fsp_msg_pool, msg);
+	unlock(&fsp_msg_pool_lock);
 }
 
 void fsp_freemsg(struct fsp_msg *msg)
@@ -297,6 +352,7 @@ void fsp_cancelmsg(struct fsp_msg *msg)
 
 	list_del(&msg->link);
 	msg->state = fsp_msg_cancelled;
+	cmdclass->depth--;
 
 	if (need_unlock)
 		unlock(&fsp_lock);
@@ -554,6 +610,13 @@ static uint32_t fsp_hir_reason_plid;
 
 void fsp_trigger_reset(uint32_t plid)
 {
+	/*
+	 * The FSP asks for the log explaining the reset once it's back, so
+	 * get it to the backend now rather than when the coalescing timer
+	 * gets around to it.
+	 */
+	elog_flush_pending();
+
 	lock(&fsp_lock);
 	fsp_hir_reason_plid = plid;
 	__fsp_trigger_reset();
@@ -1078,6 +1141,9 @@ int fsp_queue_msg(struct fsp_msg *msg, void (*comp)(struct fsp_msg *msg))
 	}
 
 	msg->state = fsp_msg_queued;
+	msg->tb_queued = mftb();
+	if (++cmdclass->depth > cmdclass->max_depth)
+		cmdclass->max_depth = cmdclass->depth;
 
 	/*
 	 * If we have initiated or about to initiate a reset/reload operation,
@@ -1103,6 +1169,7 @@ static void fsp_complete_msg(struct fsp_msg *msg)
 {
 	struct fsp_cmdclass *cmdclass = fsp_get_cmdclass(msg);
 	void (*comp)(struct fsp_msg *msg);
+	u64 lat;
 
 	assert(cmdclass);
 
@@ -1113,6 +1180,13 @@ static void fsp_complete_msg(struct fsp_msg *msg)
 	cmdclass->busy = false;
 	msg->state = fsp_msg_done;
 
+	lat = mftb() - msg->tb_queued;
+	cmdclass->depth--;
+	cmdclass->nr_complete++;
+	cmdclass->lat_total += lat;
+	if (lat > cmdclass->lat_max)
+		cmdclass->lat_max = lat;
+
 	unlock(&fsp_lock);
 	if (comp)
 		(*comp)(msg);
@@ -1529,22 +1603,43 @@ static void fsp_handle_incoming(struct fsp *fsp)
 	lock(&fsp_lock);
 }
 
+/* Where the round robin over non critical classes resumes */
+static unsigned int fsp_cmdclass_next;
+
 static void fsp_check_queues(struct fsp *fsp)
 {
-	int i;
+	const unsigned int nr = ARRAY_SIZE(fsp_cmdclass);
+	struct fsp_cmdclass *cmdclass;
+	unsigned int i, n;
+
+	/* Critical classes (surveillance, service) go first */
+	for (i = 0; i < nr; i++) {
+		cmdclass = &fsp_cmdclass[i];
 
-	/* XXX In the long run, we might want to have a queue of
-	 * classes waiting to be serviced to speed this up, either
-	 * that or a bitmap.
+		if (fsp->state != fsp_mbx_idle)
+			return;
+		if (!cmdclass->critical || cmdclass->busy ||
+		    list_empty(&cmdclass->msgq))
+			continue;
+		fsp_poke_queue(cmdclass);
+	}
+
+	/*
+	 * Then round robin over the others, starting after the last
+	 * one we posted for, so a class that always has something
+	 * queued can't starve the ones that come after it.
 	 */
-	for (i = 0; i <= (FSP_MCLASS_LAST - FSP_MCLASS_FIRST); i++) {
-		struct fsp_cmdclass *cmdclass = &fsp_cmdclass[i];
+	for (n = 0; n < nr; n++) {
+		i = (fsp_cmdclass_next + n) % nr;
+		cmdclass = &fsp_cmdclass[i];
 
 		if (fsp->state != fsp_mbx_idle)
-			break;
-		if (cmdclass->busy || list_empty(&cmdclass->msgq))
+			return;
+		if (cmdclass->critical || cmdclass->busy ||
+		    list_empty(&cmdclass->msgq))
 			continue;
 		fsp_poke_queue(cmdclass);
+		fsp_cmdclass_next = i + 1;
 	}
 }
 
@@ -2108,6 +2203,33 @@ void fsp_init(void)
 		prlog(PR_DEBUG, "FSP: No FSP on this machine\n");
 		return;
 	}
+
+	if (pool_init(&fsp_msg_pool, sizeof(struct fsp_msg),
+		      FSP_MSG_POOL_SIZE, FSP_MSG_POOL_RESERVED))
+		prerror("FSP: Failed to allocate message pool\n");
+	else
+		fsp_msg_pool_ready = true;
+}
+
+void fsp_dump_stats(void)
+{
+	struct fsp_cmdclass *cmdclass;
+	int i;
+
+	if (!fsp_present())
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(fsp_cmdclass); i++) {
+		cmdclass = &fsp_cmdclass[i];
+		if (!cmdclass->nr_complete)
+			continue;
+		prlog(PR_DEBUG, "FSP: Class %02x: %lld msgs, max depth %u,"
+		      " latency avg %lu us max %lu us\n",
+		      i + FSP_MCLASS_FIRST, cmdclass->nr_complete,
+		      cmdclass->max_depth,
+		      tb_to_usecs(cmdclass->lat_total / cmdclass->nr_complete),
+		      tb_to_usecs(cmdclass->lat_max));
+	}
 }
 
 bool fsp_present(void)
@@ -2195,6 +2317,7 @@ static void fsp_timeout_poll(void *data __unused)
 				"FSP: Response from FSP timed out,"
 				" cmd = %x subcmd = %x mod = %x state: %d\n",
 				w0 & 0xff, w1 & 0xff, (w1 >> 8) & 0xff, mstate);
+			elog_flush_pending();
 		}
 	next_bit:
 		cmdclass_resp_bitmask = cmdclass_resp_bitmask >> 1;
@@ -2295,12 +2418,16 @@ struct fsp_fetch_lid_item {
 
 	uint32_t lid;
 	uint32_t lid_no;
-	uint64_t bsize;
-	uint32_t offset;
-	void *buffer;
+	uint32_t offset;	/* Next offset to request */
+	void *buffer;		/* Where the next chunk goes */
 	size_t *length;
-	size_t remaining;
-	size_t chunk_requested;
+	size_t remaining;	/* Buffer space not requested yet */
+	unsigned int inflight;	/* Chunks with a slot */
+	bool pipelined;		/* First chunk came back, can go wide */
+	bool eof;
+	uint32_t eof_offset;
+	int error;
+	uint64_t start_tb;
 	struct list_node link;
 	int result;
 };
@@ -2312,11 +2439,28 @@ struct fsp_fetch_lid_item {
  *
  * Everything is protected with fsp_fetch_lock.
  *
- * We use PSI_DMA_FETCH TCE entry for this fetching queue. If something
- * is in the fsp_fetch_lid_queue, it means we're using this TCE entry!
+ * The PSI_DMA_FETCH TCE window is split in FSP_FETCH_SLOTS slots, each
+ * carrying one FSP_CMD_FETCH_SP_DATA. The mailbox still only lets one
+ * message per class out to the FSP at a time (cmdclass->busy), so the
+ * others wait in our queue; what we gain is that the next chunk is
+ * already queued when one completes, rather than waiting for a poller
+ * to build it. Once a LID has had all of its buffer requested (or hit
+ * the end of file), free slots are used to start on the next LID in
+ * the queue.
  *
  * If we add the first entry to fsp_fetch_lid_queue, we trigger fetching!
  */
+#define FSP_FETCH_SLOTS		4
+#define FSP_FETCH_SLOT_SIZE	(PSI_DMA_FETCH_SIZE / FSP_FETCH_SLOTS)
+
+static struct fsp_fetch_slot {
+	struct fsp_msg *msg;
+	struct fsp_fetch_lid_item *item;
+	uint32_t offset;
+	uint32_t len;
+	uint32_t bsize;
+} fsp_fetch_slots[FSP_FETCH_SLOTS];
+
 static LIST_HEAD(fsp_fetch_lid_queue);
 static LIST_HEAD(fsp_fetched_lid);
 static struct lock fsp_fetch_lock = LOCK_UNLOCKED;
@@ -2374,49 +2518,94 @@ static struct {
 };
 
 static void fsp_start_fetching_next_lid(void);
-static void fsp_fetch_lid_next_chunk(struct fsp_fetch_lid_item *last);
+
+static void fsp_fetch_lid_finish(struct fsp_fetch_lid_item *last, int result)
+{
+	unsigned long ms = tb_to_msecs(mftb() - last->start_tb);
+
+	last->result = result;
+	list_del(&last->link);
+	list_add_tail(&fsp_fetched_lid, &last->link);
+
+	prlog(PR_INFO, "FSP: LID %08x: %zu bytes in %lu ms (%lu KB/s) rc=%d\n",
+	      last->lid_no, *last->length, ms,
+	      ms ? (unsigned long)(*last->length / ms) : 0, result);
+}
+
+/* Finish the LID if it has nothing left to request or wait for */
+static bool fsp_fetch_lid_done(struct fsp_fetch_lid_item *last)
+{
+	if (last->inflight)
+		return false;
+	if (last->error) {
+		fsp_fetch_lid_finish(last, last->error);
+		return true;
+	}
+	if (last->eof || last->remaining == 0) {
+		fsp_fetch_lid_finish(last, OPAL_SUCCESS);
+		return true;
+	}
+	return false;
+}
 
 static void fsp_fetch_lid_complete(struct fsp_msg *msg)
 {
 	struct fsp_fetch_lid_item *last;
-	uint32_t woffset, wlen;
+	struct fsp_fetch_slot *slot = NULL;
+	uint32_t woffset, wlen, end;
 	uint8_t rc;
+	int i;
 
 	lock(&fsp_fetch_lock);
-	last = list_top(&fsp_fetch_lid_queue, struct fsp_fetch_lid_item, link);
-	fsp_tce_unmap(PSI_DMA_FETCH, last->bsize);
+	for (i = 0; i < FSP_FETCH_SLOTS; i++) {
+		if (fsp_fetch_slots[i].msg == msg) {
+			slot = &fsp_fetch_slots[i];
+			break;
+		}
+	}
+	assert(slot);
+	fsp_tce_unmap(PSI_DMA_FETCH + i * FSP_FETCH_SLOT_SIZE, slot->bsize);
+	slot->msg = NULL;
+	last = slot->item;
+	last->inflight--;
 
 	woffset = msg->resp->data.words[1];
 	wlen = msg->resp->data.words[2];
 	rc = (msg->resp->word1 >> 8) & 0xff;
+	fsp_freemsg(msg);
 
-	/* Fall back to a PHYP LID for kernel loads */
-	if (rc && last->lid_no == KERNEL_LID_OPAL) {
+	prlog(PR_DEBUG, "FSP: LID %x Chunk read -> rc=0x%02x off: %08x"
+	      " twritten: %08x\n", last->lid, rc, woffset, wlen);
+
+	/* Speculative chunk past the end of the LID, or LID already failed */
+	if ((last->eof && slot->offset >= last->eof_offset) || last->error)
+		goto out;
+
+	/*
+	 * Fall back to a PHYP LID for kernel loads. Only the first chunk
+	 * is ever in flight until one came back, so just start over.
+	 */
+	if (rc && last->lid_no == KERNEL_LID_OPAL &&
+	    last->lid != KERNEL_LID_PHYP && slot->offset == 0) {
 		const char *ltype = dt_prop_get_def(dt_root, "lid-type", NULL);
 		if (!ltype || strcmp(ltype, "opal")) {
 			prerror("Failed to load in OPAL mode...\n");
-			last->result = OPAL_PARAMETER;
-			last = list_pop(&fsp_fetch_lid_queue,
-					struct fsp_fetch_lid_item, link);
-			list_add_tail(&fsp_fetched_lid, &last->link);
-			fsp_start_fetching_next_lid();
-			unlock(&fsp_fetch_lock);
-			return;
+			last->error = OPAL_PARAMETER;
+			goto out;
 		}
 		printf("Trying to load as PHYP LID...\n");
-		last->lid = KERNEL_LID_PHYP;
 		/* Retry with different LID */
-		fsp_fetch_lid_next_chunk(last);
+		last->lid = KERNEL_LID_PHYP;
+		last->offset = 0;
+		last->buffer -= slot->len;
+		last->remaining += slot->len;
+		goto out;
 	}
 
 	if (rc !=0 && rc != 2) {
-		last->result = -EIO;
-		last = list_pop(&fsp_fetch_lid_queue, struct fsp_fetch_lid_item, link);
 		prerror("FSP LID %08x load ERROR %d\n", last->lid_no, rc);
-		list_add_tail(&fsp_fetched_lid, &last->link);
-		fsp_start_fetching_next_lid();
-		unlock(&fsp_fetch_lock);
-		return;
+		last->error = -EIO;
+		goto out;
 	}
 
 	/*
@@ -2432,94 +2621,114 @@ static void fsp_fetch_lid_complete(struct fsp_msg *msg)
 	 * Without this hack some systems would load partial lid and won't
 	 * be able to boot into petitboot kernel.
 	 */
-	if (rc == 0 && (wlen < last->chunk_requested))
-		last->result = OPAL_SUCCESS;
-
-	fsp_freemsg(msg);
-
-	last->remaining -= wlen;
-	*(last->length) += wlen;
-	last->buffer += wlen;
-	last->offset += wlen;
-
-	prlog(PR_DEBUG, "FSP: LID %x Chunk read -> rc=0x%02x off: %08x"
-	      " twritten: %08x\n", last->lid, rc, woffset, wlen);
-
-	fsp_fetch_lid_next_chunk(last);
-
+	end = slot->offset + wlen;
+	if (rc == 0 && wlen < slot->len) {
+		if (!last->eof || end < last->eof_offset)
+			last->eof_offset = end;
+		last->eof = true;
+	}
+	if (end > *last->length)
+		*last->length = end;
+	last->pipelined = true;
+ out:
+	slot->item = NULL;
+	fsp_start_fetching_next_lid();
 	unlock(&fsp_fetch_lock);
 }
 
-static void fsp_fetch_lid_next_chunk(struct fsp_fetch_lid_item *last)
+static bool fsp_fetch_lid_next_chunk(struct fsp_fetch_lid_item *last)
 {
+	struct fsp_fetch_slot *slot;
 	uint64_t baddr;
 	uint64_t balign, boff;
 	uint32_t chunk;
-	uint32_t taddr;
+	uint32_t taddr, tce;
 	struct fsp_msg *msg;
 	uint8_t flags = 0;
 	uint16_t id = FSP_DATASET_NONSP_LID;
 	uint32_t sub_id;
+	int i;
 
 	assert(lock_held_by_me(&fsp_fetch_lock));
 
-	if (last->remaining == 0 || last->result == OPAL_SUCCESS) {
-		last->result = OPAL_SUCCESS;
-		last = list_pop(&fsp_fetch_lid_queue,
-				struct fsp_fetch_lid_item, link);
-		list_add_tail(&fsp_fetched_lid, &last->link);
-		fsp_start_fetching_next_lid();
-		return;
-	}
-
-	baddr = (uint64_t)last->buffer;
-	balign = baddr & ~TCE_MASK;
-	boff = baddr & TCE_MASK;
-
-	chunk = last->remaining;
-	if (chunk > (PSI_DMA_FETCH_SIZE - boff))
-		chunk = PSI_DMA_FETCH_SIZE - boff;
-	last->bsize = ((boff + chunk) + TCE_MASK) & ~TCE_MASK;
-	last->chunk_requested = chunk;
+	if (last->error || last->eof || last->remaining == 0)
+		return false;
 
-	prlog(PR_DEBUG, "FSP: LID %08x chunk 0x%08x bytes balign=%llx"
-	      " boff=%llx bsize=%llx\n",
-	      last->lid_no, chunk, balign, boff, last->bsize);
+	/* Don't go wide until we know the LID is there */
+	if (last->inflight && !last->pipelined)
+		return true;
 
-	fsp_tce_map(PSI_DMA_FETCH, (void *)balign, last->bsize);
-	taddr = PSI_DMA_FETCH + boff;
+	for (i = 0; i < FSP_FETCH_SLOTS && last->remaining; i++) {
+		slot = &fsp_fetch_slots[i];
+		if (slot->item)
+			continue;
 
-	sub_id = last->lid;
+		baddr = (uint64_t)last->buffer;
+		balign = baddr & ~TCE_MASK;
+		boff = baddr & TCE_MASK;
+
+		chunk = last->remaining;
+		if (chunk > (FSP_FETCH_SLOT_SIZE - boff))
+			chunk = FSP_FETCH_SLOT_SIZE - boff;
+		slot->bsize = ((boff + chunk) + TCE_MASK) & ~TCE_MASK;
+
+		prlog(PR_DEBUG, "FSP: LID %08x chunk 0x%08x bytes balign=%llx"
+		      " boff=%llx bsize=%x slot=%d\n",
+		      last->lid_no, chunk, balign, boff, slot->bsize, i);
+
+		tce = PSI_DMA_FETCH + i * FSP_FETCH_SLOT_SIZE;
+		fsp_tce_map(tce, (void *)balign, slot->bsize);
+		taddr = tce + boff;
+
+		sub_id = last->lid;
+
+		msg = fsp_mkmsg(FSP_CMD_FETCH_SP_DATA, 6,
+				flags << 16 | id, sub_id, last->offset,
+				0, taddr, chunk);
+		if (!msg || fsp_queue_msg(msg, fsp_fetch_lid_complete)) {
+			if (msg)
+				fsp_freemsg(msg);
+			fsp_tce_unmap(tce, slot->bsize);
+			prerror("FSP: Failed to queue fetch data message\n");
+			last->error = OPAL_INTERNAL_ERROR;
+			return false;
+		}
 
-	msg = fsp_mkmsg(FSP_CMD_FETCH_SP_DATA, 6,
-			flags << 16 | id, sub_id, last->offset,
-			0, taddr, chunk);
+		slot->msg = msg;
+		slot->item = last;
+		slot->offset = last->offset;
+		slot->len = chunk;
+		last->inflight++;
+		last->buffer += chunk;
+		last->offset += chunk;
+		last->remaining -= chunk;
 
-	if (fsp_queue_msg(msg, fsp_fetch_lid_complete)) {
-		fsp_freemsg(msg);
-		prerror("FSP: Failed to queue fetch data message\n");
-		last->result = OPAL_INTERNAL_ERROR;
-		last = list_pop(&fsp_fetch_lid_queue,
-				struct fsp_fetch_lid_item, link);
-		list_add_tail(&fsp_fetched_lid, &last->link);
+		if (!last->pipelined)
+			break;
 	}
-	last->result = OPAL_BUSY;
+
+	return last->remaining != 0;
 }
 
 static void fsp_start_fetching_next_lid(void)
 {
-	struct fsp_fetch_lid_item *last;
+	struct fsp_fetch_lid_item *last, *n;
 
 	assert(lock_held_by_me(&fsp_fetch_lock));
 
-	last = list_top(&fsp_fetch_lid_queue, struct fsp_fetch_lid_item, link);
-
-	if (last == NULL)
-		return;
-
-	/* If we're not already fetching */
-	if (last->result == OPAL_EMPTY)
-		fsp_fetch_lid_next_chunk(last);
+	/*
+	 * Walk the queue in order, handing free slots to each LID until
+	 * we reach one that still has more to request.
+	 */
+	list_for_each_safe(&fsp_fetch_lid_queue, last, n, link) {
+		if (last->result == OPAL_EMPTY) {
+			last->result = OPAL_BUSY;
+			last->start_tb = mftb();
+		}
+		if (fsp_fetch_lid_next_chunk(last))
+			break;
+		fsp_fetch_lid_done(last);
+	}
 }
 
 int fsp_start_preload_resource(enum resource_id id, uint32_t idx,
@@ -2540,6 +2749,10 @@ int fsp_start_preload_resource(enum resource_id id, uint32_t idx,
 	resource->remaining = *size;
 	*size = 0;
 	resource->length = size;
+	resource->inflight = 0;
+	resource->pipelined = false;
+	resource->eof = false;
+	resource->error = 0;
 	resource->result = OPAL_EMPTY;
 
 	for (i = 0; i < ARRAY_SIZE(fsp_lid_map); i++) {
@@ -2632,6 +2845,10 @@ int fsp_preload_lid(uint32_t lid_no, char *buf, size_t *size)
 	resource->remaining = *size;
 	*size = 0;
 	resource->length = size;
+	resource->inflight = 0;
+	resource->pipelined = false;
+	resource->eof = false;
+	resource->error = 0;
 	resource->result = OPAL_EMPTY;
 
 	if (lid_no == 0)
@@ -2672,6 +2889,7 @@ int fsp_wait_lid_loaded(uint32_t lid_no)
 void fsp_used_by_console(void)
 {
 	fsp_lock.in_con_path = true;
+	fsp_msg_pool_lock.in_con_path = true;
 
 	/*
 	 * Some other processor might hold it without having
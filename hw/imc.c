@@ -18,7 +18,7 @@
 #include <xscom.h>
 #include <imc.h>
 #include <chip.h>
-#include <libxz/xz.h>
+#include <decompress.h>
 #include <device.h>
 
 /*
@@ -157,58 +157,6 @@ static struct imc_chip_cb *get_imc_cb(uint32_t chip_id)
 	return cb;
 }
 
-/*
- * Decompresses the blob obtained from the IMC pnor sub-partition
- * in "src" of size "src_size", assigns the uncompressed device tree
- * binary to "dst" and returns.
- *
- * Returns 0 on success and -1 on error.
- *
- * TODO: Ideally this should be part of generic subpartition load
- * infrastructure. And decompression can be queued as another CPU job
- */
-static int decompress(void *dst, size_t dst_size, void *src, size_t src_size)
-{
-	struct xz_dec *s;
-	struct xz_buf b;
-	int ret = 0;
-
-	/* Initialize the xz library first */
-	xz_crc32_init();
-	s = xz_dec_init(XZ_SINGLE, 0);
-	if (s == NULL) {
-		prerror("initialization error for xz\n");
-		return -1;
-	}
-
-	/*
-	 * Source address : src
-	 * Source size : src_size
-	 * Destination address : dst
-	 * Destination size : dst_src
-	 */
-	b.in = src;
-	b.in_pos = 0;
-	b.in_size = src_size;
-	b.out = dst;
-	b.out_pos = 0;
-	b.out_size = dst_size;
-
-	/* Start decompressing */
-	ret = xz_dec_run(s, &b);
-	if (ret != XZ_STREAM_END) {
-		prerror("failed to decompress subpartition\n");
-		ret = -1;
-		goto err;
-	}
-
-	return 0;
-err:
-	/* Clean up memory */
-	xz_dec_end(s);
-	return ret;
-}
-
 /*
  * Function return list of properties names for the fixup
  */
@@ -461,10 +409,12 @@ void imc_init(void)
 	/*
 	 * Decompress the compressed buffer
 	 */
-	ret = decompress(decompress_buf, MAX_DECOMPRESSED_IMC_DTB_SIZE,
-				compress_buf, compress_buf_size);
-	if (ret < 0)
+	ret = xz_decompress(decompress_buf, MAX_DECOMPRESSED_IMC_DTB_SIZE,
+			    compress_buf, compress_buf_size, NULL);
+	if (ret < 0) {
+		prerror("failed to decompress subpartition\n");
 		goto err;
+	}
 
 	/* Create a device tree entry for imc counters */
 	dev = dt_new_root("imc-counters");
@@ -72,6 +72,14 @@ static void *mmio_uart_base;
 static int uart_console_policy = UART_CONSOLE_OPAL;
 static int lpc_irq = -1;
 
+/*
+ * Once the console poller is installed, the internal console doesn't
+ * wait for the FIFO to drain: it fills what room there is and leaves
+ * the rest in the memory console for the poller, the THRE interrupt or
+ * the next message to push out.
+ */
+static bool con_deferred, con_pending;
+
 void uart_set_console_policy(int policy)
 {
 	uart_console_policy = policy;
@@ -157,12 +165,39 @@ bool uart_enabled(void)
 	return mmio_uart_base || uart_base;
 }
 
+/*
+ * We implement a simple buffer to buffer input data as some bugs in
+ * Linux make it fail to read fast enough after we get an interrupt.
+ *
+ * We use it on non-interrupt operations as well while at it because
+ * it doesn't cost us much and might help in a few cases where Linux
+ * is calling opal_poll_events() but not actually reading.
+ *
+ * Most of the time I expect we'll flush it completely to Linux into
+ * it's tty flip buffers so I don't bother with a ring buffer.
+ */
+#define IN_BUF_SIZE	0x1000
+static uint8_t	*in_buf;
+static uint32_t	in_count;
+
+/*
+ * We implement a ring buffer for output data as well to speed things
+ * up a bit. This allows us to have interrupt driven sends. This is only
+ * for the output data coming from the OPAL API, not the internal one
+ * which is already bufferred.
+ */
+#define OUT_BUF_SIZE	0x1000
+static uint8_t *out_buf;
+static uint32_t out_buf_prod;
+static uint32_t out_buf_cons;
+
 /*
  * Internal console driver (output only)
  */
 static size_t uart_con_write(const char *buf, size_t len)
 {
 	size_t written = 0;
+	bool defer = con_deferred && !bust_locks;
 
 	/* If LPC bus is bad, we just swallow data */
 	if (!lpc_ok() && !mmio_uart_base)
@@ -171,6 +206,12 @@ static size_t uart_con_write(const char *buf, size_t len)
 	lock(&uart_lock);
 	while(written < len) {
 		if (tx_room == 0) {
+			if (defer) {
+				uart_check_tx_room();
+				if (tx_room == 0)
+					break;
+				continue;
+			}
 			uart_wait_tx_room();
 			if (tx_room == 0)
 				goto bail;
@@ -179,6 +220,13 @@ static size_t uart_con_write(const char *buf, size_t len)
 			tx_room--;
 		}
 	}
+	con_pending = written < len;
+
+	/* Get the THRE interrupt to tell us when to carry on */
+	if (con_pending && in_buf && !tx_full) {
+		tx_full = true;
+		uart_update_ier();
+	}
  bail:
 	unlock(&uart_lock);
 	return written;
@@ -192,38 +240,16 @@ static struct con_ops uart_con_driver = {
  * OPAL console driver
  */
 
-/*
- * We implement a simple buffer to buffer input data as some bugs in
- * Linux make it fail to read fast enough after we get an interrupt.
- *
- * We use it on non-interrupt operations as well while at it because
- * it doesn't cost us much and might help in a few cases where Linux
- * is calling opal_poll_events() but not actually reading.
- *
- * Most of the time I expect we'll flush it completely to Linux into
- * it's tty flip buffers so I don't bother with a ring buffer.
- */
-#define IN_BUF_SIZE	0x1000
-static uint8_t	*in_buf;
-static uint32_t	in_count;
-
-/*
- * We implement a ring buffer for output data as well to speed things
- * up a bit. This allows us to have interrupt driven sends. This is only
- * for the output data coming from the OPAL API, not the internal one
- * which is already bufferred.
- */
-#define OUT_BUF_SIZE	0x1000
-static uint8_t *out_buf;
-static uint32_t out_buf_prod;
-static uint32_t out_buf_cons;
-
 /* Asynchronous flush */
 static int64_t uart_con_flush(void)
 {
 	bool tx_was_full = tx_full;
 	uint32_t out_buf_cons_initial = out_buf_cons;
 
+	/* Drop the THRE interrupt if the FIFO has drained */
+	if (tx_full)
+		uart_check_tx_room();
+
 	while(out_buf_prod != out_buf_cons) {
 		if (tx_room == 0) {
 			/*
@@ -388,24 +414,37 @@ static int64_t uart_opal_read(int64_t term_number, int64_t *length,
 
 static int64_t uart_opal_flush(int64_t term_number)
 {
+	int64_t rc;
+
 	if (term_number != 0)
 		return OPAL_PARAMETER;
 
-	return uart_con_flush();
+	lock(&uart_lock);
+	rc = uart_con_flush();
+	unlock(&uart_lock);
+
+	/* Callers wait for OPAL_SUCCESS, so include skiboot's own output */
+	if (rc == OPAL_SUCCESS && con_pending && flush_console())
+		rc = OPAL_PARTIAL;
+
+	return rc;
 }
 
 static void __uart_do_poll(u8 trace_ctx)
 {
-	if (!in_buf)
-		return;
-
-	lock(&uart_lock);
-	uart_read_to_buffer();
-	uart_con_flush();
-	uart_trace(trace_ctx, 0, tx_full, in_count);
-	unlock(&uart_lock);
+	if (in_buf) {
+		lock(&uart_lock);
+		uart_read_to_buffer();
+		uart_con_flush();
+		uart_trace(trace_ctx, 0, tx_full, in_count);
+		unlock(&uart_lock);
+
+		uart_adjust_opal_event();
+	}
 
-	uart_adjust_opal_event();
+	/* Carry on with whatever the internal console left behind */
+	if (con_pending)
+		flush_console();
 }
 
 static void uart_console_poll(void *data __unused)
@@ -488,9 +527,6 @@ static void uart_setup_opal_console(void)
 	 */
 	tx_full = rx_full = false;
 	uart_update_ier();
-
-	/* Start console poller */
-	opal_add_poller(uart_console_poll, NULL);
 }
 
 static void uart_init_opal_console(void)
@@ -663,6 +699,10 @@ void uart_init(void)
 	 */
 	lpc_used_by_console();
 
+	/* Start console poller, it also drains the internal console */
+	opal_add_poller(uart_console_poll, NULL);
+	con_deferred = true;
+
 	/* Install console backend for printf() */
 	set_console(&uart_con_driver);
 }
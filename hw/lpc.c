@@ -16,6 +16,7 @@
 
 #define pr_fmt(fmt)	"LPC: " fmt
 
+#include <inttypes.h>
 #include <skiboot.h>
 #include <xscom.h>
 #include <io.h>
@@ -190,7 +191,7 @@ static int64_t opb_write(struct lpcm *lpc, uint32_t addr, uint32_t data,
 {
 	uint64_t ctl = ECCB_CTL_MAGIC, stat;
 	int64_t rc, tout;
-	uint64_t data_reg;
+	uint64_t data_reg, regs[2], vals[2];
 
 	if (lpc->mbase)
 		return opb_mmio_write(lpc, addr, data, sz);
@@ -210,20 +211,19 @@ static int64_t opb_write(struct lpcm *lpc, uint32_t addr, uint32_t data,
 		return OPAL_PARAMETER;
 	}
 
-	rc = xscom_write(lpc->chip_id, lpc->xbase + ECCB_DATA, data_reg);
-	if (rc) {
-		log_simple_error(&e_info(OPAL_RC_LPC_WRITE),
-			"LPC: XSCOM write to ECCB DATA error %lld\n", rc);
-		return rc;
-	}
-
 	ctl = SETFIELD(ECCB_CTL_DATASZ, ctl, sz);
 	ctl = SETFIELD(ECCB_CTL_ADDRLEN, ctl, ECCB_ADDRLEN_4B);
 	ctl = SETFIELD(ECCB_CTL_ADDR, ctl, addr);
-	rc = xscom_write(lpc->chip_id, lpc->xbase + ECCB_CTL, ctl);
+
+	/* Data then control, in one go */
+	regs[0] = lpc->xbase + ECCB_DATA;
+	regs[1] = lpc->xbase + ECCB_CTL;
+	vals[0] = data_reg;
+	vals[1] = ctl;
+	rc = xscom_write_multi(lpc->chip_id, regs, vals, 2);
 	if (rc) {
 		log_simple_error(&e_info(OPAL_RC_LPC_WRITE),
-			"LPC: XSCOM write to ECCB CTL error %lld\n", rc);
+			"LPC: XSCOM write to ECCB DATA/CTL error %"PRId64"\n", rc);
 		return rc;
 	}
 
@@ -232,14 +232,14 @@ static int64_t opb_write(struct lpcm *lpc, uint32_t addr, uint32_t data,
 				&stat);
 		if (rc) {
 			log_simple_error(&e_info(OPAL_RC_LPC_WRITE),
-				"LPC: XSCOM read from ECCB STAT err %lld\n",
+				"LPC: XSCOM read from ECCB STAT err %"PRId64"\n",
 									rc);
 			return rc;
 		}
 		if (stat & ECCB_STAT_OP_DONE) {
 			if (stat & ECCB_STAT_ERR_MASK) {
 				log_simple_error(&e_info(OPAL_RC_LPC_WRITE),
-					"LPC: Error status: 0x%llx\n", stat);
+					"LPC: Error status: 0x%"PRIx64"\n", stat);
 				return OPAL_HARDWARE;
 			}
 			return OPAL_SUCCESS;
@@ -288,7 +288,7 @@ static int64_t opb_read(struct lpcm *lpc, uint32_t addr, uint32_t *data,
 	rc = xscom_write(lpc->chip_id, lpc->xbase + ECCB_CTL, ctl);
 	if (rc) {
 		log_simple_error(&e_info(OPAL_RC_LPC_READ),
-			"LPC: XSCOM write to ECCB CTL error %lld\n", rc);
+			"LPC: XSCOM write to ECCB CTL error %"PRId64"\n", rc);
 		return rc;
 	}
 
@@ -297,7 +297,7 @@ static int64_t opb_read(struct lpcm *lpc, uint32_t addr, uint32_t *data,
 				&stat);
 		if (rc) {
 			log_simple_error(&e_info(OPAL_RC_LPC_READ),
-				"LPC: XSCOM read from ECCB STAT err %lld\n",
+				"LPC: XSCOM read from ECCB STAT err %"PRId64"\n",
 									rc);
 			return rc;
 		}
@@ -305,7 +305,7 @@ static int64_t opb_read(struct lpcm *lpc, uint32_t addr, uint32_t *data,
 			uint32_t rdata = GETFIELD(ECCB_STAT_RD_DATA, stat);
 			if (stat & ECCB_STAT_ERR_MASK) {
 				log_simple_error(&e_info(OPAL_RC_LPC_READ),
-					"LPC: Error status: 0x%llx\n", stat);
+					"LPC: Error status: 0x%"PRIx64"\n", stat);
 				return OPAL_HARDWARE;
 			}
 			switch(sz) {
@@ -586,6 +586,133 @@ static int64_t opal_lpc_read(uint32_t chip_id, enum OpalLPCAddressType addr_type
 	return OPAL_SUCCESS;
 }
 
+/*
+ * Bulk accesses move a whole buffer with one call. FW space uses 4-byte
+ * accesses wherever the address is aligned, so the read size is only
+ * switched for an unaligned head or tail and IDSEL is set once. IO and
+ * MEM space only support byte accesses. The LPC lock is taken once per
+ * LPC_BULK_CHUNK bytes rather than per access, so that the console and
+ * other users still get a look in during long transfers.
+ *
+ * FIFO transfers hit the same byte address over and over, which is what
+ * data ports such as the BT interface's want.
+ */
+#define LPC_BULK_CHUNK	0x400
+
+static int64_t __lpc_bulk(struct lpcm *lpc, enum OpalLPCAddressType addr_type,
+			  uint32_t addr, void *buf, uint32_t len, bool is_write,
+			  bool fifo)
+{
+	uint32_t opb_base, sz, data, done = 0, span;
+	__be32 bdata;
+	int64_t rc = OPAL_SUCCESS;
+
+	/* Bound check the whole transfer before touching anything */
+	span = fifo ? !!len : len;
+	if (addr + span < addr)
+		return OPAL_PARAMETER;
+	switch (addr_type) {
+	case OPAL_LPC_IO:
+		if (addr + span > 0x10000)
+			return OPAL_PARAMETER;
+		break;
+	case OPAL_LPC_MEM:
+		if (addr + span > 0x10000000)
+			return OPAL_PARAMETER;
+		break;
+	case OPAL_LPC_FW:
+		if (span && ((addr + span - 1) >> 28) != (addr >> 28))
+			return OPAL_PARAMETER;
+		break;
+	default:
+		return OPAL_PARAMETER;
+	}
+
+	lock(&lpc->lock);
+	while (len) {
+		if (addr_type == OPAL_LPC_FW && len > 3 && !(addr & 3) && !fifo)
+			sz = 4;
+		else
+			sz = 1;
+
+		rc = lpc_opb_prepare(lpc, addr_type, addr, sz, &opb_base,
+				     is_write);
+		if (rc)
+			break;
+
+		/* FW space is big endian, keep the bytes in order */
+		if (is_write) {
+			if (sz == 4) {
+				memcpy(&bdata, buf, 4);
+				data = be32_to_cpu(bdata);
+			} else
+				data = *(uint8_t *)buf;
+			rc = opb_write(lpc, opb_base + addr, data, sz);
+		} else {
+			rc = opb_read(lpc, opb_base + addr, &data, sz);
+			if (rc == OPAL_SUCCESS && sz == 4) {
+				bdata = cpu_to_be32(data);
+				memcpy(buf, &bdata, 4);
+			} else if (rc == OPAL_SUCCESS)
+				*(uint8_t *)buf = data;
+		}
+		if (rc)
+			break;
+
+		if (!fifo)
+			addr += sz;
+		buf += sz;
+		len -= sz;
+		done += sz;
+		if (done >= LPC_BULK_CHUNK && len) {
+			unlock(&lpc->lock);
+			done = 0;
+			lock(&lpc->lock);
+		}
+	}
+	unlock(&lpc->lock);
+
+	return rc;
+}
+
+static int64_t lpc_bulk_default(enum OpalLPCAddressType addr_type,
+				uint32_t addr, void *buf, uint32_t len,
+				bool is_write, bool fifo)
+{
+	struct proc_chip *chip;
+
+	if (lpc_default_chip_id < 0)
+		return OPAL_PARAMETER;
+	chip = get_chip(lpc_default_chip_id);
+	if (!chip || !chip->lpc)
+		return OPAL_PARAMETER;
+	return __lpc_bulk(chip->lpc, addr_type, addr, buf, len, is_write, fifo);
+}
+
+int64_t lpc_read_bulk(enum OpalLPCAddressType addr_type, uint32_t addr,
+		      void *buf, uint32_t len)
+{
+	return lpc_bulk_default(addr_type, addr, buf, len, false, false);
+}
+
+int64_t lpc_write_bulk(enum OpalLPCAddressType addr_type, uint32_t addr,
+		       const void *buf, uint32_t len)
+{
+	return lpc_bulk_default(addr_type, addr, (void *)buf, len, true, false);
+}
+
+int64_t lpc_read_fifo(enum OpalLPCAddressType addr_type, uint32_t addr,
+		      void *buf, uint32_t len)
+{
+	return lpc_bulk_default(addr_type, addr, buf, len, false, true);
+}
+
+int64_t lpc_write_fifo(enum OpalLPCAddressType addr_type, uint32_t addr,
+		       const void *buf, uint32_t len)
+{
+	return lpc_bulk_default(addr_type, addr, (void *)buf, len, true, true);
+}
+
 bool lpc_present(void)
 {
 	return lpc_default_chip_id >= 0;
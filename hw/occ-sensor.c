@@ -20,6 +20,7 @@
 #include <sensor.h>
 #include <device.h>
 #include <cpu.h>
+#include <mem_region.h>
 
 /*
  * OCC Sensor Data
@@ -317,82 +318,191 @@ static inline u32 sensor_handler(int occ_num, int sensor_id, int attr)
 	return sensor_make_handler(SENSOR_OCC, occ_num, sensor_id, attr);
 }
 
-int occ_sensor_read(u32 handle, u32 *data)
+/*
+ * The OCC refills the ping and pong buffers in turn, clearing a buffer's
+ * valid byte while it updates it. Pick the buffer to read from:
+ *  Ping Pong	Action
+ *  0	0	Return with error
+ *  0	1	Read Pong
+ *  1	0	Read Ping
+ *  1	1	Read the buffer with latest timestamp for sensor 'id'
+ */
+static u8 *select_sensor_buffer(struct occ_sensor_data_header *hb, int id)
 {
-	struct occ_sensor_data_header *hb;
-	struct occ_sensor_name *md;
+	struct occ_sensor_name *md = get_names_block(hb);
 	struct occ_sensor_record *sping, *spong;
-	struct occ_sensor_record *sensor = NULL;
 	u8 *ping, *pong;
-	u16 id = sensor_get_rid(handle);
-	u8 occ_num = sensor_get_frc(handle);
-	u8 attr = sensor_get_attr(handle);
-
-	if (occ_num > MAX_OCCS)
-		return OPAL_PARAMETER;
-
-	if (attr > MAX_SENSOR_ATTR)
-		return OPAL_PARAMETER;
-
-	hb = get_sensor_header_block(occ_num);
-	md = get_names_block(hb);
-
-	if (hb->valid != 1)
-		return OPAL_HARDWARE;
-
-	if (id > hb->nr_sensors)
-		return OPAL_PARAMETER;
 
 	ping = (u8 *)((u64)hb + hb->reading_ping_offset);
 	pong = (u8 *)((u64)hb + hb->reading_pong_offset);
-	sping = (struct occ_sensor_record *)((u64)ping + md[id].reading_offset);
-	spong = (struct occ_sensor_record *)((u64)pong + md[id].reading_offset);
-
-	/* Check which buffer is valid  and read the data from that.
-	 * Ping Pong	Action
-	 *  0	0	Return with error
-	 *  0	1	Read Pong
-	 *  1	0	Read Ping
-	 *  1	1	Read the buffer with latest timestamp
-	 */
+
 	if (*ping && *pong) {
-		if (sping->timestamp > spong->timestamp)
-			sensor = sping;
-		else
-			sensor = spong;
-
-	} else if (*ping && !*pong) {
-		sensor = sping;
-	} else if (!*ping && *pong) {
-		sensor = spong;
-	} else if (!*ping && !*pong) {
-		prlog(PR_DEBUG, "OCC: Both ping and pong sensor buffers are invalid\n");
-		return OPAL_HARDWARE;
+		sping = (struct occ_sensor_record *)((u64)ping +
+						     md[id].reading_offset);
+		spong = (struct occ_sensor_record *)((u64)pong +
+						     md[id].reading_offset);
+		return sping->timestamp > spong->timestamp ? ping : pong;
+	} else if (*ping) {
+		return ping;
+	} else if (*pong) {
+		return pong;
 	}
 
+	prlog(PR_DEBUG, "OCC: Both ping and pong sensor buffers are invalid\n");
+	return NULL;
+}
+
+static u32 read_sensor(struct occ_sensor_record *sensor, int attr)
+{
 	switch (attr) {
 	case SENSOR_SAMPLE:
-		*data = sensor->sample;
-		break;
+		return sensor->sample;
 	case SENSOR_SAMPLE_MIN:
-		*data = sensor->sample_min;
-		break;
+		return sensor->sample_min;
 	case SENSOR_SAMPLE_MAX:
-		*data = sensor->sample_max;
-		break;
+		return sensor->sample_max;
 	case SENSOR_CSM_MIN:
-		*data = sensor->csm_min;
-		break;
+		return sensor->csm_min;
 	case SENSOR_CSM_MAX:
-		*data = sensor->csm_max;
-		break;
+		return sensor->csm_max;
 	default:
-		*data = 0;
+		return 0;
 	}
+}
+
+static int occ_sensor_check(struct occ_sensor_data_header *hb, u16 id,
+			    u8 attr)
+{
+	if (attr >= MAX_SENSOR_ATTR)
+		return OPAL_PARAMETER;
+
+	if (hb->valid != 1)
+		return OPAL_HARDWARE;
+
+	if (id >= hb->nr_sensors)
+		return OPAL_PARAMETER;
+
+	return OPAL_SUCCESS;
+}
+
+int occ_sensor_read(u32 handle, u32 *data)
+{
+	struct occ_sensor_data_header *hb;
+	struct occ_sensor_name *md;
+	u16 id = sensor_get_rid(handle);
+	u8 occ_num = sensor_get_frc(handle);
+	u8 attr = sensor_get_attr(handle);
+	u8 *buf;
+	int rc;
+
+	if (occ_num >= MAX_OCCS)
+		return OPAL_PARAMETER;
+
+	hb = get_sensor_header_block(occ_num);
+	rc = occ_sensor_check(hb, id, attr);
+	if (rc)
+		return rc;
+
+	buf = select_sensor_buffer(hb, id);
+	if (!buf)
+		return OPAL_HARDWARE;
+
+	md = get_names_block(hb);
+	*data = read_sensor((struct occ_sensor_record *)(buf +
+			    md[id].reading_offset), attr);
 
 	return OPAL_SUCCESS;
 }
 
+/*
+ * Read all the sensors of one OCC in a batch from the same buffer, so
+ * they come from the same OCC update. If the OCC started refilling that
+ * buffer before we were done, start again with the other one. If it
+ * keeps doing that, the readings we have aren't a snapshot, so they are
+ * failed with OPAL_BUSY for the OS to try again.
+ */
+#define OCC_SENSOR_BATCH_RETRIES	3
+
+static void occ_sensor_read_occ(int occ_num, struct opal_sensor_read *reqs,
+				u32 count)
+{
+	struct occ_sensor_data_header *hb = get_sensor_header_block(occ_num);
+	struct occ_sensor_name *md = get_names_block(hb);
+	struct occ_sensor_record *sensor;
+	int retries, rc;
+	u32 i, handle;
+	u8 *buf;
+
+	for (retries = 0; retries < OCC_SENSOR_BATCH_RETRIES; retries++) {
+		buf = NULL;
+		for (i = 0; i < count; i++) {
+			handle = be32_to_cpu(reqs[i].handle);
+			if (sensor_get_family(handle) != SENSOR_OCC ||
+			    sensor_get_frc(handle) != occ_num)
+				continue;
+
+			rc = occ_sensor_check(hb, sensor_get_rid(handle),
+					      sensor_get_attr(handle));
+			if (!rc && !buf) {
+				buf = select_sensor_buffer(hb,
+						sensor_get_rid(handle));
+				if (!buf)
+					rc = OPAL_HARDWARE;
+			}
+			if (!rc) {
+				sensor = (struct occ_sensor_record *)(buf +
+					md[sensor_get_rid(handle)].reading_offset);
+				reqs[i].data = cpu_to_be32(read_sensor(sensor,
+						sensor_get_attr(handle)));
+			}
+			reqs[i].rc = cpu_to_be32(rc);
+		}
+
+		lwsync();
+		if (!buf || *buf)
+			return;
+	}
+
+	prlog(PR_DEBUG, "OCC: %d sensor buffers changed while reading\n",
+	      occ_num);
+
+	for (i = 0; i < count; i++) {
+		handle = be32_to_cpu(reqs[i].handle);
+		if (sensor_get_family(handle) == SENSOR_OCC &&
+		    sensor_get_frc(handle) == occ_num &&
+		    reqs[i].rc == cpu_to_be32(OPAL_SUCCESS))
+			reqs[i].rc = cpu_to_be32(OPAL_BUSY);
+	}
+}
+
+/*
+ * Read the OCC sensors in a batch of sensor reads, leaving entries for
+ * other sensor families alone.
+ */
+void occ_sensor_read_batch(struct opal_sensor_read *reqs, u32 count)
+{
+	u32 i, handle, occs = 0;
+	int occ_num;
+
+	for (i = 0; i < count; i++) {
+		handle = be32_to_cpu(reqs[i].handle);
+		if (sensor_get_family(handle) != SENSOR_OCC)
+			continue;
+
+		occ_num = sensor_get_frc(handle);
+		if (occ_num >= MAX_OCCS)
+			reqs[i].rc = cpu_to_be32(OPAL_PARAMETER);
+		else if (!occ_sensor_base)
+			reqs[i].rc = cpu_to_be32(OPAL_HARDWARE);
+		else
+			occs |= 1 << occ_num;
+	}
+
+	for (occ_num = 0; occ_num < MAX_OCCS; occ_num++)
+		if (occs & (1 << occ_num))
+			occ_sensor_read_occ(occ_num, reqs, count);
+}
+
 static bool occ_sensor_sanity(struct occ_sensor_data_header *hb, int chipid)
 {
 	if (hb->valid != 0x01) {
@@ -464,8 +574,8 @@ static int parse_entity(const char *name, char **end)
 static void add_sensor_label(struct dt_node *node, struct occ_sensor_name *md,
 			     int chipid)
 {
-	char sname[30] = "";
-	char prefix[30] = "";
+	char sname[64] = "";
+	char prefix[18] = "";
 	int i;
 
 	if (md->location != OCC_SENSOR_LOC_SYSTEM)
@@ -543,10 +653,50 @@ static const char *get_sensor_loc_string(enum occ_sensor_location loc)
 	return "unknown";
 }
 
+/*
+ * Export the sensor data blocks to the host as a read-only reserved
+ * memory node, so it can read the sensors straight from memory. See
+ * doc/device-tree/ibm,occ-sensor-data.rst for the layout and the
+ * protocol readers follow.
+ */
+static void occ_sensors_export(u32 *chip_ids, int nr_occs)
+{
+	u64 size = nr_occs * OCC_SENSOR_DATA_BLOCK_SIZE;
+	struct dt_node *rsv, *node;
+	int i;
+
+	if (!nr_occs)
+		return;
+
+	if (!mem_range_is_reserved(occ_sensor_base, size)) {
+		prlog(PR_WARNING, "OCC: Sensor data isn't reserved, not "
+		      "exporting it\n");
+		return;
+	}
+
+	/* We're ahead of mem_region_add_dt_reserved(), so it may not exist */
+	rsv = mem_region_dt_reserved_root();
+
+	node = dt_new_addr(rsv, "ibm,occ-sensor-data", occ_sensor_base);
+	if (!node)
+		return;
+
+	for (i = 0; i < nr_occs; i++)
+		chip_ids[i] = cpu_to_be32(chip_ids[i]);
+
+	dt_add_property_string(node, "compatible", "ibm,occ-sensor-data");
+	dt_add_property_u64s(node, "reg", occ_sensor_base, size);
+	dt_add_property_cells(node, "ibm,occ-sensor-block-size",
+			      OCC_SENSOR_DATA_BLOCK_SIZE);
+	dt_add_property(node, "ibm,chip-ids", chip_ids,
+			nr_occs * sizeof(u32));
+}
+
 void occ_sensors_init(void)
 {
 	struct proc_chip *chip;
 	struct dt_node *sg;
+	u32 chip_ids[MAX_OCCS];
 	int occ_num = 0, i;
 
 	/* OCC inband sensors is only supported in P9 */
@@ -574,6 +724,9 @@ void occ_sensors_init(void)
 		struct occ_sensor_name *md;
 		u32 *phandles, phcount = 0;
 
+		if (occ_num == MAX_OCCS)
+			break;
+
 		hb = get_sensor_header_block(occ_num);
 		md = get_names_block(hb);
 
@@ -629,8 +782,10 @@ void occ_sensors_init(void)
 				dt_add_property_cells(node, "ibm,pir", c->pir);
 			phandles[phcount++] = node->phandle;
 		}
-		occ_num++;
+		chip_ids[occ_num++] = chip->id;
 		occ_add_sensor_groups(sg, phandles, phcount, chip->id);
 		free(phandles);
 	}
+
+	occ_sensors_export(chip_ids, occ_num);
 }
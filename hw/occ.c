@@ -313,72 +313,87 @@ struct occ_dynamic_data *get_occ_dynamic_data(struct proc_chip *chip)
 		OPAL_DYNAMIC_DATA_OFFSET);
 }
 
-/* Check each chip's HOMER/Sapphire area for PState valid bit */
+static uint32_t occ_init_timeout;
+
+/* Check a chip's HOMER/Sapphire area for PState valid bit */
+static bool wait_for_occ_init(struct proc_chip *chip)
+{
+	struct occ_pstate_table *occ_data;
+	int tries;
+
+	/* Check for valid homer address */
+	if (!chip->homer_base) {
+		/**
+		 * @fwts-label OCCInvalidHomerBase
+		 * @fwts-advice The HOMER base address for a chip
+		 * was not valid. This means that OCC (On Chip
+		 * Controller) will be non-functional and CPU
+		 * frequency scaling will not be functional. CPU may
+		 * be set to a safe, low frequency. Power savings in
+		 * CPU idle or CPU hotplug may be impacted.
+		 */
+		prlog(PR_ERR,"OCC: Chip: %x homer_base is not valid\n",
+			chip->id);
+		return false;
+	}
+
+	/* Get PState table address */
+	occ_data = get_occ_pstate_table(chip);
+
+	/*
+	 * Checking for occ_data->valid == 1 is ok because we clear all
+	 * homer_base+size before passing memory to host services.
+	 * This ensures occ_data->valid == 0 before OCC load
+	 */
+	tries = occ_init_timeout * 10;
+	while((occ_data->valid != 1) && tries--) {
+		time_wait_ms(100);
+	}
+	if (occ_data->valid != 1) {
+		/**
+		 * @fwts-label OCCInvalidPStateTable
+		 * @fwts-advice The pstate table for a chip
+		 * was not valid. This means that OCC (On Chip
+		 * Controller) will be non-functional and CPU
+		 * frequency scaling will not be functional. CPU may
+		 * be set to a low, safe frequency. This means
+		 * that CPU idle states and CPU frequency scaling
+		 * may not be functional.
+		 */
+		prlog(PR_ERR, "OCC: Chip: %x PState table is not valid\n",
+			chip->id);
+		return false;
+	}
+
+	prlog(PR_DEBUG, "OCC: Chip %02x Data (%016llx) = %016llx\n",
+	      chip->id, (uint64_t)occ_data, *(uint64_t *)occ_data);
+	return true;
+}
+
+/*
+ * The OCCs come up independently, so wait for them all at once rather
+ * than one after the other. That way a missing OCC costs one timeout,
+ * not one per chip.
+ */
 static bool wait_for_all_occ_init(void)
 {
 	struct proc_chip *chip;
 	struct dt_node *xn;
-	struct occ_pstate_table *occ_data;
-	int tries;
 	uint64_t start_time, end_time;
-	uint32_t timeout = 0;
 
+	occ_init_timeout = 0;
 	if (platform.occ_timeout)
-		timeout = platform.occ_timeout();
+		occ_init_timeout = platform.occ_timeout();
 
 	start_time = mftb();
-	for_each_chip(chip) {
-		/* Check for valid homer address */
-		if (!chip->homer_base) {
-			/**
-			 * @fwts-label OCCInvalidHomerBase
-			 * @fwts-advice The HOMER base address for a chip
-			 * was not valid. This means that OCC (On Chip
-			 * Controller) will be non-functional and CPU
-			 * frequency scaling will not be functional. CPU may
-			 * be set to a safe, low frequency. Power savings in
-			 * CPU idle or CPU hotplug may be impacted.
-			 */
-			prlog(PR_ERR,"OCC: Chip: %x homer_base is not valid\n",
-				chip->id);
-			return false;
-		}
-
-		/* Get PState table address */
-		occ_data = get_occ_pstate_table(chip);
-
-		/*
-		 * Checking for occ_data->valid == 1 is ok because we clear all
-		 * homer_base+size before passing memory to host services.
-		 * This ensures occ_data->valid == 0 before OCC load
-		 */
-		tries = timeout * 10;
-		while((occ_data->valid != 1) && tries--) {
-			time_wait_ms(100);
-		}
-		if (occ_data->valid != 1) {
-			/**
-			 * @fwts-label OCCInvalidPStateTable
-			 * @fwts-advice The pstate table for a chip
-			 * was not valid. This means that OCC (On Chip
-			 * Controller) will be non-functional and CPU
-			 * frequency scaling will not be functional. CPU may
-			 * be set to a low, safe frequency. This means
-			 * that CPU idle states and CPU frequency scaling
-			 * may not be functional.
-			 */
-			prlog(PR_ERR, "OCC: Chip: %x PState table is not valid\n",
-				chip->id);
-			return false;
-		}
+	if (!cpu_do_chip_jobs("wait_for_occ_init", wait_for_occ_init))
+		return false;
+	end_time = mftb();
 
+	for_each_chip(chip) {
 		if (!chip->occ_functional)
 			chip->occ_functional = true;
-
-		prlog(PR_DEBUG, "OCC: Chip %02x Data (%016llx) = %016llx\n",
-		      chip->id, (uint64_t)occ_data, *(uint64_t *)occ_data);
 	}
-	end_time = mftb();
 	prlog(PR_NOTICE, "OCC: All Chip Rdy after %lu ms\n",
 	      tb_to_msecs(end_time - start_time));
 
@@ -1537,13 +1552,24 @@ void occ_add_sensor_groups(struct dt_node *sg, u32 *phandles, int nr_phandles,
 	}
 }
 
+static int occ_pstate_nom;
+
+static bool cpu_pstates_prepare_chip(struct proc_chip *chip)
+{
+	struct cpu_thread *c;
+
+	for_each_available_core_in_chip(c, chip->id)
+		cpu_pstates_prepare_core(chip, c, occ_pstate_nom);
+	return true;
+}
+
 /* CPU-OCC PState init */
 /* Called after OCC init on P8 and P9 */
 void occ_pstates_init(void)
 {
 	struct proc_chip *chip;
-	struct cpu_thread *c;
 	int pstate_nom;
+	uint64_t start;
 	static bool occ_pstates_initialized;
 
 	/* OCC is supported in P8 and P9 */
@@ -1583,20 +1609,23 @@ void occ_pstates_init(void)
 	 * Check boundary conditions and add device tree nodes
 	 * and return nominal pstate to set for the core
 	 */
+	start = mftb();
 	if (!add_cpu_pstate_properties(&pstate_nom)) {
 		log_simple_error(&e_info(OPAL_RC_OCC_PSTATE_INIT),
 			"Skiping core cpufreq init due to OCC error\n");
 		return;
 	}
+	prlog(PR_INFO, "OCC: Pstate properties added in %lu ms\n",
+	      tb_to_msecs(mftb() - start));
 
 	/*
 	 * Setup host based pstates and set nominal frequency only in
-	 * P8.
+	 * P8. The cores of each chip are done by a job of their own.
 	 */
 	if (proc_gen == proc_gen_p8) {
-		for_each_chip(chip)
-			for_each_available_core_in_chip(c, chip->id)
-				cpu_pstates_prepare_core(chip, c, pstate_nom);
+		occ_pstate_nom = pstate_nom;
+		cpu_do_chip_jobs("cpu_pstates_prepare_chip",
+				 cpu_pstates_prepare_chip);
 	}
 
 	/* Add opal_poller to poll OCC throttle status of each chip */
@@ -225,15 +225,25 @@ struct p8_i2c_master_port {
 	uint32_t		port_num;
 	uint32_t		bit_rate_div;	/* Divisor to set bus speed*/
 	struct list_node	link;
+
+	/* Statistics, per segment of a chained request */
+	uint64_t		nr_reqs;
+	uint64_t		nr_errors;
+	uint64_t		bytes;		/* Offset and data, on success */
+	uint64_t		busy_tb;	/* Time spent on the bus */
+	uint64_t		max_tb;
 };
 
 struct p8_i2c_request {
 	struct i2c_request	req;
 	uint32_t		port_num;
 	uint64_t		timeout;
+	struct i2c_request	*chain_head;	/* Set on chained segments */
 };
 
 static int occ_i2c_unlock(struct p8_i2c_master *master);
+static int p8_i2c_start_request(struct p8_i2c_master *master,
+				struct i2c_request *req);
 
 static void p8_i2c_print_debug_info(struct p8_i2c_master_port *port,
 				    struct i2c_request *req, uint64_t end_time)
@@ -258,6 +268,10 @@ static void p8_i2c_print_debug_info(struct p8_i2c_master_port *port,
 			 " start_time=%016llx end_time=%016llx (duration=%016llx)\n",
 			 master->start_time, end_time, end_time - master->start_time);
 
+	prlog(PR_DEBUG, "I2C: Port stats--\n"
+	      " reqs=%lld\terrors=%lld\tbytes=%lld\n",
+	      port->nr_reqs, port->nr_errors, port->bytes);
+
 	/* Dump the current state of i2c registers */
 	rc = xscom_read(master->chip_id, master->xscom_base + I2C_CMD_REG,
 			&cmd);
@@ -409,22 +423,68 @@ static int p8_i2c_prog_mode(struct p8_i2c_master_port *port, bool enhanced_mode)
 	return rc;
 }
 
+static void p8_i2c_account(struct p8_i2c_master *master,
+			   struct i2c_request *req, int ret)
+{
+	struct p8_i2c_master_port *port =
+		container_of(req->bus, struct p8_i2c_master_port, bus);
+	uint64_t busy = mftb() - master->start_time;
+
+	port->nr_reqs++;
+	if (ret) {
+		port->nr_errors++;
+		return;
+	}
+	port->bytes += req->offset_bytes + req->rw_len;
+	port->busy_tb += busy;
+	if (busy > port->max_tb)
+		port->max_tb = busy;
+}
+
 static void p8_i2c_complete_request(struct p8_i2c_master *master,
 				    struct i2c_request *req, int ret)
 {
 	struct p8_i2c_request *request =
 		container_of(req, struct p8_i2c_request, req);
+	struct i2c_request *head;
 
 	/* We only complete the current top level request */
 	assert(req == list_top(&master->req_list, struct i2c_request, link));
 
 	cancel_timer_async(&master->timeout);
 	request->timeout = 0ul;
+	p8_i2c_account(master, req, ret);
+
+	/*
+	 * Chained request: start the next segment straight away, in
+	 * place of this one at the top of the queue, rather than going
+	 * through the completion and back to the poller.
+	 */
+	while (ret == OPAL_SUCCESS && req->next) {
+		head = request->chain_head ? request->chain_head : req;
+		list_del(&req->link);
+		req = req->next;
+		request = container_of(req, struct p8_i2c_request, req);
+		request->chain_head = head;
+		list_add(&master->req_list, &req->link);
+		master->state = state_idle;
+
+		ret = p8_i2c_start_request(master, req);
+		if (ret == OPAL_SUCCESS || ret == OPAL_BUSY)
+			return;
+		p8_i2c_account(master, req, ret);
+	}
 
 	list_del(&req->link);
 	master->state = state_idle;
 	req->result = ret;
 
+	/* The client only hears about the chain as a whole */
+	if (request->chain_head) {
+		req = request->chain_head;
+		req->result = ret;
+	}
+
 	/* Schedule re-enabling of sensor cache */
 	if (master->occ_cache_dis)
 		schedule_timer(&master->sensor_cache,
@@ -1314,17 +1374,30 @@ static int p8_i2c_queue_request(struct i2c_request *req)
 	struct p8_i2c_master_port *port =
 		container_of(bus, struct p8_i2c_master_port, bus);
 	struct p8_i2c_master *master = port->master;
+	struct i2c_request *seg;
 	int rc = 0;
 
-	/* Parameter check */
-	if (req->rw_len > I2C_MAX_TFR_LEN) {
-		prlog(PR_ERR, "I2C: Too large transfer %d bytes\n", req->rw_len);
-		return OPAL_PARAMETER;
-	}
+	/* Parameter check, on every segment of a chain */
+	for (seg = req; seg; seg = seg->next) {
+		if (seg->rw_len > I2C_MAX_TFR_LEN) {
+			prlog(PR_ERR, "I2C: Too large transfer %d bytes\n",
+			      seg->rw_len);
+			return OPAL_PARAMETER;
+		}
 
-	if (req->offset_bytes > 4) {
-		prlog(PR_ERR, "I2C: Invalid offset size %d\n", req->offset_bytes);
-		return OPAL_PARAMETER;
+		if (seg->offset_bytes > 4) {
+			prlog(PR_ERR, "I2C: Invalid offset size %d\n",
+			      seg->offset_bytes);
+			return OPAL_PARAMETER;
+		}
+
+		if (seg->bus != bus) {
+			prlog(PR_ERR, "I2C: Chained request on another bus\n");
+			return OPAL_PARAMETER;
+		}
+
+		container_of(seg, struct p8_i2c_request, req)->chain_head =
+			NULL;
 	}
 	lock(&master->lock);
 	list_add_tail(&master->req_list, &req->link);
@@ -1542,6 +1615,34 @@ static const char *compat[] = {
 	"ibm,centaur-i2cm"
 };
 
+void p8_i2c_dump_stats(void)
+{
+	struct p8_i2c_master_port *port;
+	struct p8_i2c_master *master;
+	struct proc_chip *chip;
+	uint64_t ok, busy_us;
+
+	for_each_chip(chip) {
+		list_for_each(&chip->i2cms, master, link) {
+			list_for_each(&master->ports, port, link) {
+				if (!port->nr_reqs)
+					continue;
+				ok = port->nr_reqs - port->nr_errors;
+				busy_us = tb_to_usecs(port->busy_tb);
+				prlog(PR_DEBUG, "I2C: Chip %08x Eng. %d Port %d:"
+				      " %lld reqs, %lld errors, %lld bytes,"
+				      " avg %lld us max %ld us, %lld KB/s\n",
+				      master->chip_id, master->engine_id,
+				      port->port_num, port->nr_reqs,
+				      port->nr_errors, port->bytes,
+				      ok ? busy_us / ok : 0,
+				      tb_to_usecs(port->max_tb),
+				      busy_us ? port->bytes * 1000 / busy_us : 0);
+			}
+		}
+	}
+}
+
 static void p8_i2c_add_bus_prop(struct p8_i2c_master_port *port)
 {
 	const struct dt_property *c, *p;
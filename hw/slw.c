@@ -1141,26 +1141,29 @@ static void slw_patch_regs(struct proc_chip *chip)
 	}
 }
 
-static void slw_init_chip_p9(struct proc_chip *chip)
+static bool slw_init_chip_p9(struct proc_chip *chip)
 {
 	struct cpu_thread *c;
+	bool ok = true;
 
 	prlog(PR_DEBUG, "SLW: Init chip 0x%x\n", chip->id);
 
 	/* At power ON setup inits for power-mgt */
 	for_each_available_core_in_chip(c, chip->id)
-		slw_set_overrides_p9(chip, c);
+		ok &= slw_set_overrides_p9(chip, c);
+	return ok;
 }
-static void slw_init_chip(struct proc_chip *chip)
+static bool slw_init_chip(struct proc_chip *chip)
 {
 	int64_t rc;
 	struct cpu_thread *c;
+	bool ok = true;
 
 	prlog(PR_DEBUG, "SLW: Init chip 0x%x\n", chip->id);
 
 	if (!chip->slw_base) {
 		prerror("SLW: No image found !\n");
-		return;
+		return false;
 	}
 
 	/* Check actual image size */
@@ -1173,7 +1176,7 @@ static void slw_init_chip(struct proc_chip *chip)
 		chip->slw_base = 0;
 		chip->slw_bar_size = 0;
 		chip->slw_image_size = 0;
-		return;
+		return false;
 	}
 	prlog(PR_DEBUG, "SLW: Image size from image: 0x%llx\n",
 	      chip->slw_image_size);
@@ -1189,8 +1192,9 @@ static void slw_init_chip(struct proc_chip *chip)
 
 	/* At power ON setup inits for fast-sleep */
 	for_each_available_core_in_chip(c, chip->id) {
-		idle_prepare_core(chip, c);
+		ok &= idle_prepare_core(chip, c);
 	}
+	return ok;
 }
 
 /* Workarounds while entering fast-sleep */
@@ -1401,13 +1405,13 @@ void slw_update_timer_expiry(uint64_t new_target)
 
 	do {
 		/* Grab generation and spin if odd */
-		_xscom_lock();
+		_xscom_lock(slw_timer_chip);
 		for (;;) {
 			rc = _xscom_read(slw_timer_chip, 0xE0006, &gen, false);
 			if (rc) {
 				prerror("SLW: Error %lld reading tmr gen "
 					" count\n", rc);
-				_xscom_unlock();
+				_xscom_unlock(slw_timer_chip);
 				return;
 			}
 			if (!(gen & 1))
@@ -1432,7 +1436,7 @@ void slw_update_timer_expiry(uint64_t new_target)
 				 */
 				prerror("SLW: timer stuck, falling back to OPAL pollers. You will likely have slower I2C and may have experienced increased jitter.\n");
 				prlog(PR_DEBUG, "SLW: Stuck with odd generation !\n");
-				_xscom_unlock();
+				_xscom_unlock(slw_timer_chip);
 				slw_has_timer = false;
 				slw_dump_timer_ffdc();
 				return;
@@ -1442,7 +1446,7 @@ void slw_update_timer_expiry(uint64_t new_target)
 		rc = _xscom_write(slw_timer_chip, 0x5003A, req, false);
 		if (rc) {
 			prerror("SLW: Error %lld writing tmr request\n", rc);
-			_xscom_unlock();
+			_xscom_unlock(slw_timer_chip);
 			return;
 		}
 
@@ -1451,10 +1455,10 @@ void slw_update_timer_expiry(uint64_t new_target)
 		if (rc) {
 			prerror("SLW: Error %lld re-reading tmr gen "
 				" count\n", rc);
-			_xscom_unlock();
+			_xscom_unlock(slw_timer_chip);
 			return;
 		}
-		_xscom_unlock();
+		_xscom_unlock(slw_timer_chip);
 	} while(gen != gen2);
 
 	/* Check if the timer is working. If at least 1ms has elapsed
@@ -1508,16 +1512,16 @@ static void slw_init_timer(void)
 	slw_has_timer = true;
 }
 
+/*
+ * The per core init is a string of XSCOMs to each core, so give each
+ * chip a job of its own.
+ */
 void slw_init(void)
 {
-	struct proc_chip *chip;
-
 	if (proc_gen == proc_gen_p8) {
-		for_each_chip(chip)
-			slw_init_chip(chip);
+		cpu_do_chip_jobs("slw_init_chip", slw_init_chip);
 		slw_init_timer();
 	} else if (proc_gen == proc_gen_p9) {
-		for_each_chip(chip)
-			slw_init_chip_p9(chip);
+		cpu_do_chip_jobs("slw_init_chip_p9", slw_init_chip_p9);
 	}
 }
@@ -0,0 +1,361 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Run the BT driver against a simulated BMC that can work on several
+ * requests at once, and check every response makes it back to the
+ * right message with the in-flight window closed and opened.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <compiler.h>
+
+#define __TEST__
+
+/* Don't include these: PPC-specific, provided below */
+#define __IO_H
+#define __PROCESSOR_H
+
+static inline void smt_lowest(void) { }
+static inline void smt_medium(void) { }
+
+/* One tick of the simulation is a microsecond */
+static unsigned long stamp;
+#define mftb()		(stamp * 512)
+
+#include <skiboot.h>
+#include <lock.h>
+#include <lpc.h>
+#include <ipmi.h>
+#include <timer.h>
+
+#define SIM_BASE	0xe4
+#define SIM_BMC_DEPTH	4	/* Requests the BMC works on at once */
+#define SIM_BMC_LAT	200	/* Ticks to service a request */
+#define SIM_MSGS	10
+#define SIM_DLEN	16
+
+static struct {
+	bool h2b_atn, b2h_atn, h_busy, sms_atn;
+	bool stuck;	/* Never picks up a request */
+	uint8_t h2b[256], b2h[256];
+	unsigned int h2b_wr, b2h_rd;
+	struct {
+		uint8_t req[256];
+		unsigned long ready;
+	} pending[SIM_BMC_DEPTH];
+	unsigned int npending;
+	unsigned long cycles;
+} sim;
+
+static void sim_bmc_step(void)
+{
+	unsigned int i, len;
+	uint8_t *req;
+
+	/* Pick up a request from the FIFO, if we have room for it */
+	if (sim.h2b_atn && !sim.stuck && sim.npending < SIM_BMC_DEPTH) {
+		memcpy(sim.pending[sim.npending].req, sim.h2b, sizeof(sim.h2b));
+		sim.pending[sim.npending].ready = stamp + SIM_BMC_LAT;
+		sim.npending++;
+		sim.h2b_atn = false;
+	}
+
+	/* Post the oldest finished response */
+	if (sim.b2h_atn || sim.h_busy || !sim.npending ||
+	    sim.pending[0].ready > stamp)
+		return;
+
+	req = sim.pending[0].req;
+	len = req[0] - 3;
+	sim.b2h[0] = len + 4;
+	sim.b2h[1] = req[1] + (1 << 2);
+	sim.b2h[2] = req[2];
+	sim.b2h[3] = req[3];
+	sim.b2h[4] = 0;
+	for (i = 0; i < len; i++)
+		sim.b2h[5 + i] = req[4 + i] + 1;
+	sim.b2h_atn = true;
+
+	sim.npending--;
+	memmove(&sim.pending[0], &sim.pending[1],
+		sim.npending * sizeof(sim.pending[0]));
+}
+
+static uint8_t sim_ctrl_read(void)
+{
+	return (sim.h2b_atn ? 0x04 : 0) | (sim.b2h_atn ? 0x08 : 0) |
+		(sim.sms_atn ? 0x10 : 0) | (sim.h_busy ? 0x40 : 0);
+}
+
+static void sim_ctrl_write(uint8_t v)
+{
+	if (v & 0x01)
+		sim.h2b_wr = 0;
+	if (v & 0x02)
+		sim.b2h_rd = 0;
+	if (v & 0x04)
+		sim.h2b_atn = true;
+	if (v & 0x08)
+		sim.b2h_atn = false;
+	if (v & 0x10)
+		sim.sms_atn = false;
+	if (v & 0x40)
+		sim.h_busy = !sim.h_busy;
+}
+
+int64_t lpc_write(enum OpalLPCAddressType addr_type, uint32_t addr,
+		  uint32_t data, uint32_t sz)
+{
+	assert(addr_type == OPAL_LPC_IO && sz == 1);
+	sim.cycles++;
+	switch (addr - SIM_BASE) {
+	case 0:
+		sim_ctrl_write(data);
+		break;
+	case 1:
+		sim.h2b[sim.h2b_wr++ & 0xff] = data;
+		break;
+	}
+	return OPAL_SUCCESS;
+}
+
+int64_t lpc_read(enum OpalLPCAddressType addr_type, uint32_t addr,
+		 uint32_t *data, uint32_t sz)
+{
+	assert(addr_type == OPAL_LPC_IO && sz == 1);
+	sim.cycles++;
+	switch (addr - SIM_BASE) {
+	case 0:
+		*data = sim_ctrl_read();
+		break;
+	case 1:
+		*data = sim.b2h[sim.b2h_rd++ & 0xff];
+		break;
+	default:
+		*data = 0;
+	}
+	return OPAL_SUCCESS;
+}
+
+int64_t lpc_read_fifo(enum OpalLPCAddressType addr_type, uint32_t addr,
+		      void *buf, uint32_t len)
+{
+	uint32_t i, d;
+
+	for (i = 0; i < len; i++) {
+		lpc_read(addr_type, addr, &d, 1);
+		((uint8_t *)buf)[i] = d;
+	}
+	return OPAL_SUCCESS;
+}
+
+int64_t lpc_write_fifo(enum OpalLPCAddressType addr_type, uint32_t addr,
+		       const void *buf, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		lpc_write(addr_type, addr, ((const uint8_t *)buf)[i], 1);
+	return OPAL_SUCCESS;
+}
+
+bool lpc_ok(void)
+{
+	return true;
+}
+
+void lock(struct lock *l __unused)
+{
+}
+
+void unlock(struct lock *l __unused)
+{
+}
+
+#define zalloc(size) calloc((size), 1)
+
+#undef pr_fmt
+#include "../bt.c"
+
+#include "../../ccan/list/list.c"
+#include "../../core/pool.c"
+
+unsigned long tb_hz = 512000000;
+struct dt_node *dt_root;
+enum proc_chip_quirks proc_chip_quirks;
+
+void _prlog(int log_level, const char* fmt, ...)
+{
+	va_list ap;
+
+	if (log_level > PR_NOTICE)
+		return;
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+}
+
+static unsigned int completed, timed_out;
+
+void ipmi_cmd_done(uint8_t cmd, uint8_t netfn __unused, uint8_t cc,
+		   struct ipmi_msg *msg)
+{
+	int i;
+
+	if (cc == IPMI_TIMEOUT_ERR) {
+		timed_out++;
+		bt_free_ipmi_msg(msg);
+		return;
+	}
+	assert(cc == IPMI_CC_NO_ERROR);
+	assert(msg->cmd == cmd);
+	assert(msg->resp_size == SIM_DLEN);
+	for (i = 0; i < SIM_DLEN; i++)
+		assert(msg->data[i] == (uint8_t)(cmd + i + 1));
+	completed++;
+	bt_free_ipmi_msg(msg);
+}
+
+void ipmi_sms_attention(void)
+{
+}
+
+struct ipmi_msg *ipmi_mkmsg(int interface __unused, uint32_t code __unused,
+			    void (*complete)(struct ipmi_msg *) __unused,
+			    void *user_data __unused, void *req_data __unused,
+			    size_t req_size __unused,
+			    size_t resp_size __unused)
+{
+	return NULL;
+}
+
+uint64_t schedule_timer(struct timer *t __unused, uint64_t how_long __unused)
+{
+	return 0;
+}
+
+void init_timer(struct timer *t __unused, timer_func_t expiry __unused,
+		void *data __unused)
+{
+}
+
+const char *nvram_query(const char *key __unused)
+{
+	return NULL;
+}
+
+static void queue_msgs(int nr)
+{
+	struct ipmi_msg *msg;
+	int i, j;
+
+	for (i = 0; i < nr; i++) {
+		msg = bt_alloc_ipmi_msg(SIM_DLEN, SIM_DLEN);
+		assert(msg);
+		assert(container_of(msg, struct bt_msg, ipmi_msg)->pool ==
+		       &bt_msg_pools[0]);
+		msg->netfn = 0x0a << 2;
+		msg->cmd = 0x40 + i;
+		for (j = 0; j < SIM_DLEN; j++)
+			msg->data[j] = msg->cmd + j;
+		bt_add_ipmi_msg(msg);
+	}
+}
+
+static unsigned long run(int window)
+{
+	unsigned long start = stamp;
+
+	memset(&sim, 0, sizeof(sim));
+	bt.window = window;
+	bt.caps.num_requests = SIM_BMC_DEPTH;
+	completed = 0;
+
+	queue_msgs(SIM_MSGS);
+
+	while (completed < SIM_MSGS) {
+		assert(stamp - start < 1000000);
+		stamp++;
+		sim_bmc_step();
+		bt_poll(NULL, NULL, mftb());
+		assert(bt.inflight <= window);
+	}
+	assert(list_empty(&bt.msgq));
+	assert(bt.queue_len == 0 && bt.inflight == 0);
+
+	/* Everything came from, and went back to, the small pool */
+	assert(bt_msg_pools[0].pool.free_count == bt_msg_pools[0].count);
+
+	printf("BT window %d: %d msgs in %lu us, %lu LPC cycles\n",
+	       window, SIM_MSGS, stamp - start, sim.cycles);
+	return stamp - start;
+}
+
+/*
+ * A BMC that never takes the first request off us. The rest of the
+ * queue can't get into the FIFO, so it has to time out without ever
+ * being counted as in flight.
+ */
+static void run_stuck(void)
+{
+	memset(&sim, 0, sizeof(sim));
+	sim.stuck = true;
+	bt.window = 1;
+	completed = timed_out = 0;
+
+	queue_msgs(3);
+
+	while (!list_empty(&bt.msgq)) {
+		assert(stamp < 1000000000);
+		stamp += 1000;
+		bt_poll(NULL, NULL, mftb());
+		assert(bt.inflight >= 0 && bt.inflight <= 1);
+	}
+	assert(timed_out == 3 && completed == 0);
+	assert(bt.queue_len == 0 && bt.inflight == 0);
+	assert(bt_msg_pools[0].pool.free_count == bt_msg_pools[0].count);
+}
+
+int main(void)
+{
+	unsigned long serial, pipelined;
+
+	bt.base_addr = SIM_BASE;
+	bt.caps.input_buf_len = BT_FIFO_LEN;
+	bt.caps.output_buf_len = BT_FIFO_LEN;
+	bt.caps.msg_timeout = BT_MSG_TIMEOUT;
+	bt.caps.max_retries = BT_MAX_RETRIES;
+	list_head_init(&bt.msgq);
+	bt_init_msg_pools();
+
+	serial = run(1);
+	pipelined = run(SIM_BMC_DEPTH);
+
+	/* The BMC works on requests in parallel, so this should pay off */
+	assert(pipelined * 2 < serial);
+
+	run_stuck();
+
+	return 0;
+}
@@ -0,0 +1,329 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Check lpc_read_bulk()/lpc_write_bulk() against a simulated LPC host
+ * controller, both through the ECCB XSCOM interface and the MMIO window,
+ * and compare with byte at a time lpc_read()/lpc_write(). Throughput is
+ * estimated from the number of XSCOMs and MMIOs issued.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <compiler.h>
+
+#define __TEST__
+
+/* Don't include these: PPC-specific, provided below */
+#define __IO_H
+#define __PROCESSOR_H
+
+static inline void smt_lowest(void) { }
+static inline void smt_medium(void) { }
+
+#include <xscom.h>
+#include <lock.h>
+#include <chip.h>
+
+/* Rough costs of one access, to turn counts into a throughput */
+#define XSCOM_NS	1000
+#define MMIO_NS		250
+
+#define SIM_FW_SIZE	0x100000
+#define SIM_MBASE	((void *)0x4000000000ul)
+
+static uint8_t sim_fw[SIM_FW_SIZE];
+static uint32_t sim_idsel, sim_rdsz = 1;
+static uint64_t sim_data, sim_stat;
+static unsigned long sim_xscoms, sim_mmios;
+
+static uint32_t fw_rdsz(uint32_t val)
+{
+	switch (val) {
+	case 0x00000000:
+		return 1;
+	case 0x01000000:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+/* Big endian access to the simulated OPB address space */
+static uint32_t sim_opb_read(uint32_t addr, uint32_t sz)
+{
+	uint32_t v = 0, i;
+
+	if (addr == 0xc0012000 + 0x24)
+		return sim_idsel;
+	if (addr >= 0xf0000000) {
+		addr -= 0xf0000000;
+		assert(sim_idsel == 0);
+		assert(sz == sim_rdsz);
+		assert(addr + sz <= SIM_FW_SIZE);
+		for (i = 0; i < sz; i++)
+			v = (v << 8) | sim_fw[addr + i];
+		return v;
+	}
+	return 0;
+}
+
+static void sim_opb_write(uint32_t addr, uint32_t v, uint32_t sz)
+{
+	int i;
+
+	if (addr == 0xc0012000 + 0x24) {
+		sim_idsel = v & 0xf;
+		return;
+	}
+	if (addr == 0xc0012000 + 0x28) {
+		sim_rdsz = fw_rdsz(v);
+		return;
+	}
+	if (addr >= 0xf0000000) {
+		addr -= 0xf0000000;
+		assert(addr + sz <= SIM_FW_SIZE);
+		for (i = sz - 1; i >= 0; i--) {
+			sim_fw[addr + i] = v;
+			v >>= 8;
+		}
+	}
+}
+
+/* ECCB registers, behind XSCOM */
+int _xscom_write(uint32_t partid __unused, uint64_t pcb_addr, uint64_t val,
+		 bool take_lock __unused)
+{
+	uint32_t sz = (val >> 56) & 0xf, addr = val;
+
+	sim_xscoms++;
+	switch (pcb_addr & 0xf) {
+	case 3: /* ECCB_DATA */
+		sim_data = val;
+		return 0;
+	case 0: /* ECCB_CTL */
+		if (val & (1ul << (63 - 15)))
+			sim_stat = (uint64_t)(sim_opb_read(addr, sz) <<
+					      ((4 - sz) * 8)) << 26;
+		else
+			sim_opb_write(addr, sim_data >> (64 - sz * 8), sz);
+		sim_stat |= 1ul << (63 - 52);
+		return 0;
+	}
+	abort();
+}
+
+int _xscom_read(uint32_t partid __unused, uint64_t pcb_addr, uint64_t *val,
+		bool take_lock __unused)
+{
+	sim_xscoms++;
+	assert((pcb_addr & 0xf) == 2); /* ECCB_STAT */
+	*val = sim_stat;
+	return 0;
+}
+
+int xscom_write_multi(uint32_t partid, const uint64_t *addrs,
+		      const uint64_t *vals, unsigned int count)
+{
+	unsigned int i;
+
+	/* Counts as one access: it's the lock and setup we save */
+	sim_xscoms -= count - 1;
+	for (i = 0; i < count; i++)
+		xscom_write(partid, addrs[i], vals[i]);
+	return 0;
+}
+
+/* MMIO window */
+#define MMIO_ADDR(p)	((uint32_t)((void *)(p) - SIM_MBASE))
+
+static inline uint8_t in_8(const volatile uint8_t *addr)
+{
+	sim_mmios++;
+	return sim_opb_read(MMIO_ADDR(addr), 1);
+}
+
+static inline uint16_t in_be16(const volatile uint16_t *addr)
+{
+	sim_mmios++;
+	return sim_opb_read(MMIO_ADDR(addr), 2);
+}
+
+static inline uint32_t in_be32(const volatile uint32_t *addr)
+{
+	sim_mmios++;
+	return sim_opb_read(MMIO_ADDR(addr), 4);
+}
+
+static inline void out_8(volatile uint8_t *addr, uint8_t val)
+{
+	sim_mmios++;
+	sim_opb_write(MMIO_ADDR(addr), val, 1);
+}
+
+static inline void out_be16(volatile uint16_t *addr, uint16_t val)
+{
+	sim_mmios++;
+	sim_opb_write(MMIO_ADDR(addr), val, 2);
+}
+
+static inline void out_be32(volatile uint32_t *addr, uint32_t val)
+{
+	sim_mmios++;
+	sim_opb_write(MMIO_ADDR(addr), val, 4);
+}
+
+static unsigned long sim_locks;
+
+void lock(struct lock *l __unused)
+{
+	sim_locks++;
+}
+
+void unlock(struct lock *l __unused)
+{
+}
+
+#define zalloc(size) calloc((size), 1)
+
+#undef pr_fmt
+#include "../lpc.c"
+
+#include "../../ccan/list/list.c"
+
+unsigned long tb_hz = 512000000;
+struct dt_node *dt_root;
+bool manufacturing_mode;
+
+void _prlog(int log_level __unused, const char* fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+}
+
+uint32_t log_simple_error(struct opal_err_info *e_info __unused,
+			  const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+	return 0;
+}
+
+static struct proc_chip sim_chip;
+static struct lpcm sim_lpc;
+
+struct proc_chip *get_chip(uint32_t chip_id __unused)
+{
+	return &sim_chip;
+}
+
+void time_wait_nopoll(unsigned long duration __unused)
+{
+}
+
+static uint8_t buf[0x10000 + 8], ref[0x10000 + 8];
+
+static void report(const char *what, uint32_t len)
+{
+	unsigned long ns = sim_xscoms * XSCOM_NS + sim_mmios * MMIO_NS;
+
+	printf("LPC %-24s: %6lu XSCOMs %6lu MMIOs %6lu locks, ~%lu KB/s\n",
+	       what, sim_xscoms, sim_mmios, sim_locks,
+	       ns ? len * 1000000ul / ns : 0);
+	sim_xscoms = sim_mmios = sim_locks = 0;
+}
+
+static void test_read(const char *what, uint32_t off, uint32_t len)
+{
+	uint32_t i, v;
+
+	memset(buf, 0, sizeof(buf));
+	for (i = 0; i < len; i++) {
+		assert(lpc_read(OPAL_LPC_FW, off + i, &v, 1) == OPAL_SUCCESS);
+		buf[i] = v;
+	}
+	assert(memcmp(buf, sim_fw + off, len) == 0);
+	report("byte reads", len);
+
+	memset(buf, 0, sizeof(buf));
+	assert(lpc_read_bulk(OPAL_LPC_FW, off, buf, len) == OPAL_SUCCESS);
+	assert(memcmp(buf, sim_fw + off, len) == 0);
+	report(what, len);
+}
+
+static void test_write(const char *what, uint32_t off, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		ref[i] = rand();
+	assert(lpc_write_bulk(OPAL_LPC_FW, off, ref, len) == OPAL_SUCCESS);
+	assert(memcmp(ref, sim_fw + off, len) == 0);
+	report(what, len);
+}
+
+int main(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < SIM_FW_SIZE; i++)
+		sim_fw[i] = rand();
+
+	sim_lpc.xbase = 0xb0020;
+	sim_lpc.fw_idsel = 0xff;
+	sim_lpc.fw_rdsz = 0xff;
+	sim_chip.lpc = &sim_lpc;
+	lpc_default_chip_id = 0;
+
+	/* Through ECCB */
+	test_read("ECCB bulk read", 0x1000, 0x10000);
+	test_read("ECCB unaligned bulk read", 0x2003, 0x1ff6);
+	test_write("ECCB bulk write", 0x4001, 0x8000);
+
+	/* Through the MMIO window */
+	sim_lpc.mbase = SIM_MBASE;
+	test_read("MMIO bulk read", 0x1000, 0x10000);
+	test_read("MMIO unaligned bulk read", 0x2003, 0x1ff6);
+	test_write("MMIO bulk write", 0x4001, 0x8000);
+
+	/* A FIFO transfer keeps hitting the same address */
+	assert(lpc_read_fifo(OPAL_LPC_FW, 0x100, buf, 8) == OPAL_SUCCESS);
+	for (i = 0; i < 8; i++)
+		assert(buf[i] == sim_fw[0x100]);
+	assert(lpc_write_fifo(OPAL_LPC_FW, 0x200, ref, 8) == OPAL_SUCCESS);
+	assert(sim_fw[0x200] == ref[7]);
+	assert(lpc_read_fifo(OPAL_LPC_IO, 0xffff, buf, 8) == OPAL_SUCCESS);
+	report("FIFO", 24);
+
+	/* Can't cross an IDSEL segment or go past IO space */
+	assert(lpc_read_bulk(OPAL_LPC_FW, 0x0ffffffe, buf, 4) ==
+	       OPAL_PARAMETER);
+	assert(lpc_read_bulk(OPAL_LPC_IO, 0xfffe, buf, 4) == OPAL_PARAMETER);
+
+	return 0;
+}
@@ -0,0 +1,230 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Read OCC sensors from a made up sensor data area, one at a time and
+ * in batches, and check a batch reads each OCC from a single buffer,
+ * even when the OCC starts refilling it under our feet.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <compiler.h>
+
+#define __TEST__
+
+/* Don't include these: PPC-specific, provided below */
+#define __PROCESSOR_H
+
+static inline void smt_lowest(void) { }
+static inline void smt_medium(void) { }
+
+static void (*lwsync_hook)(void);
+
+static inline void lwsync(void)
+{
+	if (lwsync_hook)
+		lwsync_hook();
+}
+
+#include <skiboot.h>
+#include <opal-api.h>
+
+#include "../occ-sensor.c"
+
+#define NR_OCCS		2
+#define NR_SENSORS	4
+
+enum proc_gen proc_gen;
+struct dt_node *sensor_node, *opal_node, *dt_root;
+
+void _prlog(int log_level __unused, const char* fmt __unused, ...)
+{
+}
+
+static uint8_t *ping(int occ)
+{
+	struct occ_sensor_data_header *hb = get_sensor_header_block(occ);
+
+	return (uint8_t *)hb + hb->reading_ping_offset;
+}
+
+static uint8_t *pong(int occ)
+{
+	struct occ_sensor_data_header *hb = get_sensor_header_block(occ);
+
+	return (uint8_t *)hb + hb->reading_pong_offset;
+}
+
+static struct occ_sensor_record *record(uint8_t *buf, int id)
+{
+	return (struct occ_sensor_record *)(buf + 8 + id * 48);
+}
+
+/* Samples are 1000 * occ + 100 for ping or 200 for pong + sensor */
+static void fill(uint8_t *buf, int occ, int base, uint64_t timestamp)
+{
+	int i;
+
+	buf[0] = 1;
+	for (i = 0; i < NR_SENSORS; i++) {
+		record(buf, i)->timestamp = timestamp;
+		record(buf, i)->sample = 1000 * occ + base + i;
+		record(buf, i)->csm_max = 1000 * occ + base + i + 50;
+	}
+}
+
+static void setup(void *area)
+{
+	struct occ_sensor_data_header *hb;
+	struct occ_sensor_name *md;
+	int occ, i;
+
+	occ_sensor_base = (u64)area;
+	for (occ = 0; occ < NR_OCCS; occ++) {
+		hb = get_sensor_header_block(occ);
+		hb->valid = 1;
+		hb->nr_sensors = NR_SENSORS;
+		hb->names_offset = 0x400;
+		hb->reading_ping_offset = 0xdc00;
+		hb->reading_pong_offset = 0x18c00;
+		md = get_names_block(hb);
+		for (i = 0; i < NR_SENSORS; i++)
+			md[i].reading_offset = 8 + i * 48;
+	}
+}
+
+/* The OCC starts refilling ping, having just finished pong */
+static void occ_update(void)
+{
+	lwsync_hook = NULL;
+	ping(0)[0] = 0;
+	fill(pong(0), 0, 300, 30);
+}
+
+/* The OCC refills whichever buffer of OCC 0 we were reading, every time */
+static void occ_busy(void)
+{
+	if (ping(0)[0]) {
+		ping(0)[0] = 0;
+		fill(pong(0), 0, 200, 40);
+	} else {
+		pong(0)[0] = 0;
+		fill(ping(0), 0, 100, 40);
+	}
+}
+
+static void batch(struct opal_sensor_read *reqs, u32 count)
+{
+	u32 i;
+
+	for (i = 0; i < count; i++)
+		reqs[i].rc = cpu_to_be32(OPAL_INTERNAL_ERROR);
+	occ_sensor_read_batch(reqs, count);
+}
+
+#define HANDLE(occ, id, attr)	sensor_make_handler(SENSOR_OCC, occ, id, attr)
+
+int main(void)
+{
+	struct opal_sensor_read reqs[2 * NR_SENSORS + 4];
+	void *area;
+	u32 data;
+	int i, n;
+
+	area = calloc(NR_OCCS, OCC_SENSOR_DATA_BLOCK_SIZE);
+	assert(area);
+	setup(area);
+
+	/* OCC 0 has both buffers valid, ping being newer but for sensor 2 */
+	fill(ping(0), 0, 100, 20);
+	fill(pong(0), 0, 200, 10);
+	record(pong(0), 2)->timestamp = 25;
+	/* OCC 1 only has pong */
+	fill(pong(1), 1, 200, 10);
+
+	/* On its own, a sensor is read from whichever was updated last */
+	assert(occ_sensor_read(HANDLE(0, 1, SENSOR_SAMPLE), &data) == 0);
+	assert(data == 101);
+	assert(occ_sensor_read(HANDLE(0, 2, SENSOR_SAMPLE), &data) == 0);
+	assert(data == 202);
+	assert(occ_sensor_read(HANDLE(1, 3, SENSOR_CSM_MAX), &data) == 0);
+	assert(data == 1253);
+	assert(occ_sensor_read(HANDLE(0, NR_SENSORS, SENSOR_SAMPLE), &data) ==
+	       OPAL_PARAMETER);
+	assert(occ_sensor_read(HANDLE(0, 0, MAX_SENSOR_ATTR), &data) ==
+	       OPAL_PARAMETER);
+	assert(occ_sensor_read(HANDLE(MAX_OCCS, 0, SENSOR_SAMPLE), &data) ==
+	       OPAL_PARAMETER);
+
+	/* In a batch, every sensor of an OCC comes from the same buffer */
+	n = 0;
+	for (i = 0; i < NR_SENSORS; i++) {
+		reqs[n++].handle = cpu_to_be32(HANDLE(1, i, SENSOR_SAMPLE));
+		reqs[n++].handle = cpu_to_be32(HANDLE(0, i, SENSOR_SAMPLE));
+	}
+	reqs[n++].handle = cpu_to_be32(HANDLE(0, NR_SENSORS, SENSOR_SAMPLE));
+	reqs[n++].handle = cpu_to_be32(HANDLE(MAX_OCCS, 0, SENSOR_SAMPLE));
+	reqs[n++].handle = cpu_to_be32(sensor_make_handler(SENSOR_DTS, 0, 0, 0));
+	reqs[n++].handle = cpu_to_be32(HANDLE(0, 0, SENSOR_CSM_MAX));
+	batch(reqs, n);
+
+	for (i = 0; i < NR_SENSORS; i++) {
+		assert(be32_to_cpu(reqs[2 * i].rc) == OPAL_SUCCESS);
+		assert(be32_to_cpu(reqs[2 * i].data) == 1200u + i);
+		assert(be32_to_cpu(reqs[2 * i + 1].rc) == OPAL_SUCCESS);
+		assert(be32_to_cpu(reqs[2 * i + 1].data) == 100u + i);
+	}
+	assert(be32_to_cpu(reqs[n - 4].rc) == (u32)OPAL_PARAMETER);
+	assert(be32_to_cpu(reqs[n - 3].rc) == (u32)OPAL_PARAMETER);
+	assert(be32_to_cpu(reqs[n - 2].rc) == (u32)OPAL_INTERNAL_ERROR);
+	assert(be32_to_cpu(reqs[n - 1].data) == 150);
+
+	/* If the OCC takes the buffer back while we read, OCC 0 is re-read */
+	lwsync_hook = occ_update;
+	batch(reqs, 2 * NR_SENSORS);
+	for (i = 0; i < NR_SENSORS; i++) {
+		assert(be32_to_cpu(reqs[2 * i].data) == 1200u + i);
+		assert(be32_to_cpu(reqs[2 * i + 1].data) == 300u + i);
+	}
+	assert(!lwsync_hook);
+
+	/* If it never lets go, OCC 0 is told to come back later */
+	lwsync_hook = occ_busy;
+	batch(reqs, 2 * NR_SENSORS);
+	lwsync_hook = NULL;
+	for (i = 0; i < NR_SENSORS; i++) {
+		assert(be32_to_cpu(reqs[2 * i].rc) == OPAL_SUCCESS);
+		assert(be32_to_cpu(reqs[2 * i].data) == 1200u + i);
+		assert(be32_to_cpu(reqs[2 * i + 1].rc) == (u32)OPAL_BUSY);
+	}
+
+	/* Nothing valid at all */
+	ping(0)[0] = 0;
+	pong(0)[0] = 0;
+	batch(reqs, 2 * NR_SENSORS);
+	assert(be32_to_cpu(reqs[0].rc) == OPAL_SUCCESS);
+	assert(be32_to_cpu(reqs[1].rc) == (u32)OPAL_HARDWARE);
+
+	free(area);
+	return 0;
+}
@@ -0,0 +1,59 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdlib.h>
+
+/*
+ * Add any stub functions required for linking here. The drivers under
+ * test call these from paths the tests don't take (probing the device
+ * tree, registering with other subsystems), so they just abort.
+ */
+static void stub_function(void)
+{
+	abort();
+}
+
+#define STUB(fnname) \
+	void fnname(void) __attribute__((weak, alias ("stub_function")))
+
+STUB(__dt_add_property_cells);
+STUB(__dt_add_property_u64s);
+STUB(__opal_register);
+STUB(dt_add_property);
+STUB(dt_add_property_string);
+STUB(dt_find_compatible_node);
+STUB(dt_find_property);
+STUB(dt_get_address);
+STUB(dt_get_chip_id);
+STUB(dt_has_node_property);
+STUB(dt_new);
+STUB(dt_new_addr);
+STUB(dt_prop_get_cell);
+STUB(dt_prop_get_u32);
+STUB(dt_property_get_cell);
+STUB(first_available_core_in_chip);
+STUB(next_available_core_in_chip);
+STUB(pir_to_core_id);
+STUB(next_chip);
+STUB(lock_held_by_me);
+STUB(ipmi_register_backend);
+STUB(ipmi_queue_msg);
+STUB(ipmi_free_msg);
+STUB(lpc_register_client);
+STUB(mem_range_is_reserved);
+STUB(mem_region_dt_reserved_root);
+STUB(occ_add_sensor_groups);
+STUB(xscom_ok);
+STUB(xscom_used_by_console);
@@ -290,6 +290,16 @@ struct xive_cpu_state {
 	uint8_t		eqgen;
 	void		*eqmmio;
 	uint64_t	total_irqs;
+
+	/* XICS emulation statistics, only updated by the owner thread */
+	struct {
+		uint64_t	acks;
+		uint64_t	fast_acks;
+		uint64_t	eois;
+		uint64_t	fast_eois;
+		uint64_t	replays;
+		uint64_t	dups;
+	} stats;
 };
 
 #ifdef XIVE_PERCPU_LOG
@@ -416,6 +426,8 @@ struct xive {
 #endif
 	/* EQ allocation bitmap. Each bit represent 8 EQs */
 	bitmap_t	*eq_map;
+	/* Lowest bit of eq_map that might be clear */
+	uint32_t	eq_alloc_hint;
 
 #ifdef USE_INDIRECT
 	/* Indirect NVT/VP table. NULL entries are unallocated, count is
@@ -949,13 +961,18 @@ static uint32_t xive_alloc_eq_set(struct xive *x, bool alloc_indirect __unused)
 
 	assert(x->eq_map);
 
-	/* Allocate from the EQ bitmap. Each bit is 8 EQs */
-	idx = bitmap_find_zero_bit(*x->eq_map, 0, MAX_EQ_COUNT >> 3);
+	/* Allocate from the EQ bitmap. Each bit is 8 EQs. Everything
+	 * below the hint is known to be in use so start from there
+	 * rather than rescanning the whole map every time.
+	 */
+	idx = bitmap_find_zero_bit(*x->eq_map, x->eq_alloc_hint,
+				   (MAX_EQ_COUNT >> 3) - x->eq_alloc_hint);
 	if (idx < 0) {
 		xive_dbg(x, "Allocation from EQ bitmap failed !\n");
 		return XIVE_ALLOC_NO_SPACE;
 	}
 	bitmap_set_bit(*x->eq_map, idx);
+	x->eq_alloc_hint = idx + 1;
 
 	idx <<= 3;
 
@@ -1013,6 +1030,8 @@ static void xive_free_eq_set(struct xive *x, uint32_t eqs)
 
 	idx = eqs >> 3;
 	bitmap_clr_bit(*x->eq_map, idx);
+	if (idx < x->eq_alloc_hint)
+		x->eq_alloc_hint = idx;
 }
 
 #ifdef USE_INDIRECT
@@ -1166,9 +1185,21 @@ static void xive_init_vp_allocator(void)
 	}
 }
 
+static int xive_try_alloc_vps(struct xive *x, uint32_t order)
+{
+	int vp;
+
+	assert(x->vp_buddy);
+	lock(&x->lock);
+	vp = buddy_alloc(x->vp_buddy, order);
+	unlock(&x->lock);
+
+	return vp;
+}
+
 static uint32_t xive_alloc_vps(uint32_t order)
 {
-	struct proc_chip *chip;
+	struct proc_chip *chip, *local;
 	struct xive *x = NULL;
 	int vp = -1;
 
@@ -1176,17 +1207,21 @@ static uint32_t xive_alloc_vps(uint32_t order)
 	if (order < 1)
 		order = 1;
 
-	/* Try on every chip */
+	/* Prefer the chip of the caller, the VPs are likely to be
+	 * dispatched there, then try on every other chip
+	 */
+	local = get_chip(this_cpu()->chip_id);
+	if (local && local->xive) {
+		x = local->xive;
+		vp = xive_try_alloc_vps(x, order);
+	}
 	for_each_chip(chip) {
-		x = chip->xive;
-		if (!x)
-			continue;
-		assert(x->vp_buddy);
-		lock(&x->lock);
-		vp = buddy_alloc(x->vp_buddy, order);
-		unlock(&x->lock);
 		if (vp >= 0)
 			break;
+		x = chip->xive;
+		if (!x || chip == local)
+			continue;
+		vp = xive_try_alloc_vps(x, order);
 	}
 	if (vp < 0)
 		return XIVE_ALLOC_NO_SPACE;
@@ -2719,6 +2754,7 @@ static struct xive *init_one_xive(struct dt_node *np)
 	assert(x->eq_map);
 	/* Make sure we don't hand out 0 */
 	bitmap_set_bit(*x->eq_map, 0);
+	x->eq_alloc_hint = 1;
 
 	x->int_enabled_map = zalloc(BITMAP_BYTES(MAX_INT_ENTRIES));
 	assert(x->int_enabled_map);
@@ -3124,6 +3160,7 @@ static uint32_t xive_read_eq(struct xive_cpu_state *xs, bool just_peek)
 	if (copies > 1) {
 		struct xive_eq *eq;
 
+		xs->stats.dups++;
 		prerror("Wow ! Dups of irq %x, found %d copies !\n",
 			cur & 0x7fffffff, copies);
 		prerror("[%08x > %08x %08x %08x %08x ...] eqgen=%x eqptr=%x jp=%d\n",
@@ -3176,6 +3213,13 @@ static void opal_xive_update_cppr(struct xive_cpu_state *xs, u8 cppr)
 	xs->cppr = cppr;
 	out_8(xs->tm_ring1 + TM_QW3_HV_PHYS + TM_CPPR, cppr);
 
+	/* Order the CPPR update against reading the MFRR. This pairs
+	 * with the sync in opal_xive_set_mfrr() so that at least one
+	 * side sees the other's update and the IPI can't get lost,
+	 * which lets the fast paths call this without xs->lock.
+	 */
+	sync();
+
 	/* Trigger the IPI if it's still more favored than the CPPR
 	 *
 	 * This can lead to a bunch of spurrious retriggers if the
@@ -3186,6 +3230,40 @@ static void opal_xive_update_cppr(struct xive_cpu_state *xs, u8 cppr)
 		xive_ipi_trigger(xs->xive, GIRQ_TO_IDX(xs->ipi_irq));
 }
 
+#ifdef EQ_ALWAYS_NOTIFY
+/*
+ * Lock-free EOI for the common case of a regular source with nothing
+ * else in the queue. Everything touched here is only ever modified by
+ * the owner thread, the CPPR vs. MFRR race with opal_xive_set_mfrr()
+ * is handled by opal_xive_update_cppr().
+ */
+static bool opal_xive_eoi_fast(struct xive_cpu_state *xs, uint32_t isn,
+			       uint8_t cppr)
+{
+	/* Our emulated IPI and replays take the slow path */
+	if (isn == 2 || xive_read_eq(xs, true))
+		return false;
+	if (!xive_from_isn(isn))
+		return false;
+
+	log_add(xs, LOG_TYPE_EOI, 3, isn, xs->eqptr, xs->eqgen);
+
+	irq_source_eoi(isn);
+	opal_xive_update_cppr(xs, cppr);
+	xs->stats.fast_eois++;
+
+	return true;
+}
+#else
+static inline bool opal_xive_eoi_fast(struct xive_cpu_state *xs __unused,
+				      uint32_t isn __unused,
+				      uint8_t cppr __unused)
+{
+	/* The EQ level EOI needs the slow path */
+	return false;
+}
+#endif
+
 static int64_t opal_xive_eoi(uint32_t xirr)
 {
 	struct cpu_thread *c = this_cpu();
@@ -3217,6 +3295,10 @@ static int64_t opal_xive_eoi(uint32_t xirr)
 	/* Limit supported CPPR values from OS */
 	cppr = xive_sanitize_cppr(xirr >> 24);
 
+	xs->stats.eois++;
+	if (opal_xive_eoi_fast(xs, isn, cppr))
+		goto done;
+
 	lock(&xs->lock);
 
 	log_add(xs, LOG_TYPE_EOI, 3, isn, xs->eqptr, xs->eqgen);
@@ -3238,6 +3320,7 @@ static int64_t opal_xive_eoi(uint32_t xirr)
 	if (xive_read_eq(xs, true)) {
 		xive_cpu_vdbg(c, "  isn %08x, skip, queue non empty\n", xirr);
 		xs->pending |= 1 << XIVE_EMULATION_PRIO;
+		xs->stats.replays++;
 	}
 #ifndef EQ_ALWAYS_NOTIFY
 	else {
@@ -3256,8 +3339,10 @@ static int64_t opal_xive_eoi(uint32_t xirr)
 		 */
 		if (eoi_val & 1) {
 			sync();
-			if (xive_read_eq(xs, true))
+			if (xive_read_eq(xs, true)) {
 				xs->pending |= 1 << XIVE_EMULATION_PRIO;
+				xs->stats.replays++;
+			}
 		}
 	}
 #endif
@@ -3288,6 +3373,7 @@ static int64_t opal_xive_eoi(uint32_t xirr)
 
 	unlock(&xs->lock);
 
+ done:
 	/* Return whether something is pending that is suitable for
 	 * delivery considering the new CPPR value. This can be done
 	 * without lock as these fields are per-cpu.
@@ -3295,6 +3381,42 @@ static int64_t opal_xive_eoi(uint32_t xirr)
 	return opal_xive_check_pending(xs, cppr) ? 1 : 0;
 }
 
+/*
+ * Lock-free XIRR fetch for the common case: the ACK returned a single
+ * interrupt at our emulation priority, nothing was left pending by a
+ * previous EOI and the entry is in the queue. This only ever lowers
+ * the CPPR so it can't race with opal_xive_set_mfrr() losing an IPI.
+ */
+static bool opal_xive_get_xirr_fast(struct xive_cpu_state *xs, uint16_t ack,
+				    uint8_t old_cppr, uint32_t *out_xirr)
+{
+	uint32_t val;
+
+	if (xs->pending || old_cppr <= XIVE_EMULATION_PRIO)
+		return false;
+	if (GETFIELD(TM_QW3_NSR_HE, (ack >> 8)) != TM_QW3_NSR_HE_PHYS ||
+	    (ack & 0xff) != XIVE_EMULATION_PRIO)
+		return false;
+
+	/* Spurrious IPB bit, let the slow path sort out the CPPR */
+	val = xive_read_eq(xs, false);
+	if (!val)
+		return false;
+
+	xs->cppr = XIVE_EMULATION_PRIO;
+
+	/* Convert to magic IPI if needed */
+	if (val == xs->ipi_irq)
+		val = 2;
+	*out_xirr = (old_cppr << 24) | val;
+
+	log_add(xs, LOG_TYPE_XIRR2, 5, xs->cppr, xs->pending,
+		*out_xirr, xs->eqptr, xs->eqgen);
+	xs->stats.fast_acks++;
+
+	return true;
+}
+
 static int64_t opal_xive_get_xirr(uint32_t *out_xirr, bool just_poll)
 {
 	struct cpu_thread *c = this_cpu();
@@ -3311,8 +3433,6 @@ static int64_t opal_xive_get_xirr(uint32_t *out_xirr, bool just_poll)
 
 	*out_xirr = 0;
 
-	lock(&xs->lock);
-
 	/*
 	 * Due to the need to fetch multiple interrupts from the EQ, we
 	 * need to play some tricks.
@@ -3335,6 +3455,9 @@ static int64_t opal_xive_get_xirr(uint32_t *out_xirr, bool just_poll)
 		      __in_be64(xs->tm_ring1 + TM_QW3_HV_PHYS),
 		      __in_be32(xs->tm_ring1 + TM_QW3_HV_PHYS + 8));
 
+	/* Capture the old CPPR which we will return with the interrupt */
+	old_cppr = xs->cppr;
+
 	/* Perform the HV Ack cycle */
 	if (just_poll)
 		ack = __in_be64(xs->tm_ring1 + TM_QW3_HV_PHYS) >> 48;
@@ -3343,8 +3466,13 @@ static int64_t opal_xive_get_xirr(uint32_t *out_xirr, bool just_poll)
 	sync();
 	xive_cpu_vdbg(c, "get_xirr,%s=%04x\n", just_poll ? "POLL" : "ACK", ack);
 
-	/* Capture the old CPPR which we will return with the interrupt */
-	old_cppr = xs->cppr;
+	if (!just_poll) {
+		xs->stats.acks++;
+		if (opal_xive_get_xirr_fast(xs, ack, old_cppr, out_xirr))
+			return OPAL_SUCCESS;
+	}
+
+	lock(&xs->lock);
 
 	switch(GETFIELD(TM_QW3_NSR_HE, (ack >> 8))) {
 	case TM_QW3_NSR_HE_NONE:
@@ -3481,6 +3609,8 @@ static int64_t opal_xive_set_mfrr(uint32_t cpu, uint8_t mfrr)
 	old_mfrr = xs->mfrr;
 	xive_cpu_vdbg(c, "  Setting MFRR to %x, old is %x\n", mfrr, old_mfrr);
 	xs->mfrr = mfrr;
+	/* Pairs with the sync in opal_xive_update_cppr() */
+	sync();
 	if (old_mfrr > mfrr && mfrr < xs->cppr)
 		xive_ipi_trigger(xs->xive, GIRQ_TO_IDX(xs->ipi_irq));
 	unlock(&xs->lock);
@@ -4050,8 +4180,11 @@ static void xive_reset_one(struct xive *x)
 			if (eq->w0 & EQ_W0_FIRMWARE)
 				eq_firmware = true;
 		}
-		if (!eq_firmware)
+		if (!eq_firmware) {
 			bitmap_clr_bit(*x->eq_map, i);
+			if (i < x->eq_alloc_hint)
+				x->eq_alloc_hint = i;
+		}
 	}
 
 	/* Take out all VPs from HW and reset all CPPRs to 0 */
@@ -4194,6 +4327,12 @@ static int64_t opal_xive_reset(uint64_t version)
 	return OPAL_SUCCESS;
 }
 
+/* Used by fast reboot to put XIVE back in the state we booted with */
+void xive_reset(void)
+{
+	opal_xive_reset(XIVE_MODE_EMU);
+}
+
 static int64_t opal_xive_free_vp_block(uint64_t vp_base)
 {
 	uint32_t blk, idx, i, count;
@@ -4273,6 +4412,7 @@ static int64_t opal_xive_free_vp_block(uint64_t vp_base)
 
 static int64_t opal_xive_alloc_vp_block(uint32_t alloc_order)
 {
+	struct xive *locked_x = NULL;
 	uint32_t vp_base, eqs, count, i;
 	int64_t rc;
 
@@ -4288,7 +4428,13 @@ static int64_t opal_xive_alloc_vp_block(uint32_t alloc_order)
 		return OPAL_RESOURCE;
 	}
 
-	/* Allocate EQs and initialize VPs */
+	/* Allocate EQs and initialize VPs.
+	 *
+	 * Consecutive VPs of the block live on the same XIVE (the block
+	 * ID only changes every "count / number of chips" VPs in block
+	 * group mode) so we keep that XIVE locked across them rather than
+	 * taking the lock once per EQ set.
+	 */
 	count = 1 << alloc_order;
 	for (i = 0; i < count; i++) {
 		uint32_t vp_id = vp_base + i;
@@ -4298,7 +4444,8 @@ static int64_t opal_xive_alloc_vp_block(uint32_t alloc_order)
 
 		if (!xive_decode_vp(vp_id, &blk, &idx, NULL, NULL)) {
 			prerror("XIVE: Couldn't decode VP id %u\n", vp_id);
-			return OPAL_INTERNAL_ERROR;
+			rc = OPAL_INTERNAL_ERROR;
+			goto fail;
 		}
 		x = xive_from_pc_blk(blk);
 		if (!x) {
@@ -4314,10 +4461,15 @@ static int64_t opal_xive_alloc_vp_block(uint32_t alloc_order)
 			goto fail;
 		}
 
+		if (x != locked_x) {
+			if (locked_x)
+				unlock(&locked_x->lock);
+			lock(&x->lock);
+			locked_x = x;
+		}
+
 		/* Allocate EQs, if fails, free the VPs and return */
-		lock(&x->lock);
 		eqs = xive_alloc_eq_set(x, false);
-		unlock(&x->lock);
 		if (XIVE_ALLOC_IS_ERR(eqs)) {
 			if (eqs == XIVE_ALLOC_NO_IND)
 				rc = OPAL_XIVE_PROVISIONING;
@@ -4334,8 +4486,12 @@ static int64_t opal_xive_alloc_vp_block(uint32_t alloc_order)
 		vp->w1 = (blk << 28) | eqs;
 		vp->w5 = 0xff000000;
 	}
+	if (locked_x)
+		unlock(&locked_x->lock);
 	return vp_base;
  fail:
+	if (locked_x)
+		unlock(&locked_x->lock);
 	opal_xive_free_vp_block(vp_base);
 
 	return rc;
@@ -4514,6 +4670,35 @@ static int64_t opal_xive_dump_vp(uint32_t vp_id)
 	return OPAL_SUCCESS;
 }
 
+static void xive_dump_emu_stats(uint32_t pir, struct xive_cpu_state *xs)
+{
+	prlog(PR_INFO, "CPU[%04x]: acks=%lld (fast %lld) eois=%lld (fast %lld)"
+	      " replays=%lld dups=%lld\n", pir,
+	      xs->stats.acks, xs->stats.fast_acks,
+	      xs->stats.eois, xs->stats.fast_eois,
+	      xs->stats.replays, xs->stats.dups);
+}
+
+static int64_t opal_xive_dump_emu_stats(uint32_t pir)
+{
+	struct cpu_thread *c;
+
+	/* All ones means all CPUs */
+	if (pir != 0xffffffff) {
+		c = find_cpu_by_pir(pir);
+		if (!c)
+			return OPAL_PARAMETER;
+		if (c->xstate)
+			xive_dump_emu_stats(pir, c->xstate);
+		return OPAL_SUCCESS;
+	}
+	for_each_present_cpu(c) {
+		if (c->xstate)
+			xive_dump_emu_stats(c->pir, c->xstate);
+	}
+	return OPAL_SUCCESS;
+}
+
 static int64_t opal_xive_dump_emu(uint32_t pir)
 {
 	struct cpu_thread *c = find_cpu_by_pir(pir);
@@ -4537,6 +4722,7 @@ static int64_t opal_xive_dump_emu(uint32_t pir)
 	prlog(PR_INFO, "CPU[%04x]: cppr=%02x mfrr=%02x pend=%02x"
 	      " prev_cppr=%02x total_irqs=%llx\n", pir,
 	      xs->cppr, xs->mfrr, xs->pending, xs->prev_cppr, xs->total_irqs);
+	xive_dump_emu_stats(pir, xs);
 
 	prlog(PR_INFO, "CPU[%04x]: EQ IDX=%x MSK=%x G=%d [%08x %08x %08x > %08x %08x %08x %08x ...]\n",
 	      pir,  xs->eqptr, xs->eqmsk, xs->eqgen,
@@ -4630,6 +4816,8 @@ static int64_t opal_xive_dump(uint32_t type, uint32_t id)
 		return opal_xive_dump_vp(id);
 	case XIVE_DUMP_EMU_STATE:
 		return opal_xive_dump_emu(id);
+	case XIVE_DUMP_EMU_STATS:
+		return opal_xive_dump_emu_stats(id);
 	default:
 		return OPAL_PARAMETER;
 	}
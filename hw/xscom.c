@@ -24,6 +24,7 @@
 #include <errorlog.h>
 #include <opal-api.h>
 #include <timebase.h>
+#include <nvram.h>
 
 /* Mask of bits to clear in HMER before an access */
 #define HMER_CLR_MASK	(~(SPR_HMER_XSCOM_FAIL | \
@@ -59,8 +60,39 @@ static struct {
  * we can have issues on the issuer side if multiple threads try to
  * send XSCOMs simultaneously (HMER responses get mixed up), so just
  * use a global lock instead
+ *
+ * On systems known not to be affected, the "xscom-lock=per-chip" NVRAM
+ * option switches back to a per-target lock (chip->xscom_lock) so that
+ * accesses to different chips (HMI, OCC, PRD, chiptod...) don't
+ * serialize on each other. The mode can change at runtime, so callers
+ * must use xscom_lock_chip() which re-checks it once the lock is held.
  */
 static struct lock xscom_lock = LOCK_UNLOCKED;
+static bool xscom_per_chip_locking;
+
+static struct lock *xscom_get_lock(uint32_t gcid)
+{
+	struct proc_chip *chip;
+
+	if (!xscom_per_chip_locking)
+		return &xscom_lock;
+	chip = get_chip(gcid);
+	return chip ? &chip->xscom_lock : &xscom_lock;
+}
+
+static struct lock *xscom_lock_chip(uint32_t gcid)
+{
+	struct lock *l;
+
+	for (;;) {
+		l = xscom_get_lock(gcid);
+		lock(l);
+		if (l == xscom_get_lock(gcid))
+			return l;
+		/* Locking mode changed under us, try again */
+		unlock(l);
+	}
+}
 
 static inline void *xscom_addr(uint32_t gcid, uint32_t pcb_addr)
 {
@@ -238,6 +270,17 @@ static bool xscom_gcid_ok(uint32_t gcid)
 	return get_chip(gcid) != NULL;
 }
 
+/* Statistics, updated with the XSCOM lock for that chip held */
+static void xscom_account(uint32_t gcid, int64_t retries, int64_t rc)
+{
+	struct proc_chip *chip = get_chip(gcid);
+
+	chip->xscom_ops++;
+	chip->xscom_retries += retries;
+	if (rc)
+		chip->xscom_errors++;
+}
+
 /*
  * Low level XSCOM access functions, perform a single direct xscom
  * access via MMIO
@@ -265,8 +308,10 @@ static int __xscom_read(uint32_t gcid, uint32_t pcb_addr, uint64_t *val)
 		hmer = xscom_wait_done();
 
 		/* Check for error */
-		if (!(hmer & SPR_HMER_XSCOM_FAIL))
+		if (!(hmer & SPR_HMER_XSCOM_FAIL)) {
+			xscom_account(gcid, retries, OPAL_SUCCESS);
 			return OPAL_SUCCESS;
+		}
 
 		/* Handle error and possibly eventually retry */
 		ret = xscom_handle_error(hmer, gcid, pcb_addr, false, retries);
@@ -274,6 +319,7 @@ static int __xscom_read(uint32_t gcid, uint32_t pcb_addr, uint64_t *val)
 			break;
 	}
 
+	xscom_account(gcid, retries, ret);
 	prerror("XSCOM: Read failed, ret =  %lld\n", ret);
 	return ret;
 }
@@ -301,8 +347,10 @@ static int __xscom_write(uint32_t gcid, uint32_t pcb_addr, uint64_t val)
 		hmer = xscom_wait_done();
 
 		/* Check for error */
-		if (!(hmer & SPR_HMER_XSCOM_FAIL))
+		if (!(hmer & SPR_HMER_XSCOM_FAIL)) {
+			xscom_account(gcid, retries, OPAL_SUCCESS);
 			return OPAL_SUCCESS;
+		}
 
 		/* Handle error and possibly eventually retry */
 		ret = xscom_handle_error(hmer, gcid, pcb_addr, true, retries);
@@ -310,6 +358,7 @@ static int __xscom_write(uint32_t gcid, uint32_t pcb_addr, uint64_t val)
 			break;
 	}
 
+	xscom_account(gcid, retries, ret);
 	prerror("XSCOM: Write failed, ret =  %lld\n", ret);
 	return ret;
 }
@@ -463,14 +512,29 @@ static uint32_t xscom_decode_chiplet(uint32_t partid, uint64_t *pcb_addr)
 	return gcid;
 }
 
-void _xscom_lock(void)
+void _xscom_lock(uint32_t gcid)
 {
-	lock(&xscom_lock);
+	xscom_lock_chip(gcid);
 }
 
-void _xscom_unlock(void)
+void _xscom_unlock(uint32_t gcid)
 {
-	unlock(&xscom_lock);
+	/* The mode can't change while we hold the lock */
+	unlock(xscom_get_lock(gcid));
+}
+
+/* Direct vs indirect access, with the lock for that chip held */
+static int __xscom_access(uint32_t gcid, uint64_t pcb_addr, uint64_t *val,
+			  bool is_write)
+{
+	if (pcb_addr & XSCOM_ADDR_IND_FLAG) {
+		if (is_write)
+			return xscom_indirect_write(gcid, pcb_addr, *val);
+		return xscom_indirect_read(gcid, pcb_addr, val);
+	}
+	if (is_write)
+		return __xscom_write(gcid, pcb_addr & 0x7fffffff, *val);
+	return __xscom_read(gcid, pcb_addr & 0x7fffffff, val);
 }
 
 /*
@@ -478,6 +542,7 @@ void _xscom_unlock(void)
  */
 int _xscom_read(uint32_t partid, uint64_t pcb_addr, uint64_t *val, bool take_lock)
 {
+	struct lock *l = NULL;
 	uint32_t gcid;
 	int rc;
 
@@ -517,17 +582,13 @@ int _xscom_read(uint32_t partid, uint64_t pcb_addr, uint64_t *val, bool take_loc
 
 	/* HW822317 requires us to do global locking */
 	if (take_lock)
-		lock(&xscom_lock);
+		l = xscom_lock_chip(gcid);
 
-	/* Direct vs indirect access */
-	if (pcb_addr & XSCOM_ADDR_IND_FLAG)
-		rc = xscom_indirect_read(gcid, pcb_addr, val);
-	else
-		rc = __xscom_read(gcid, pcb_addr & 0x7fffffff, val);
+	rc = __xscom_access(gcid, pcb_addr, val, false);
 
 	/* Unlock it */
 	if (take_lock)
-		unlock(&xscom_lock);
+		unlock(l);
 	return rc;
 }
 
@@ -535,6 +596,7 @@ opal_call(OPAL_XSCOM_READ, xscom_read, 3);
 
 int _xscom_write(uint32_t partid, uint64_t pcb_addr, uint64_t val, bool take_lock)
 {
+	struct lock *l = NULL;
 	uint32_t gcid;
 	int rc;
 
@@ -562,21 +624,96 @@ int _xscom_write(uint32_t partid, uint64_t pcb_addr, uint64_t val, bool take_loc
 
 	/* HW822317 requires us to do global locking */
 	if (take_lock)
-		lock(&xscom_lock);
+		l = xscom_lock_chip(gcid);
 
-	/* Direct vs indirect access */
-	if (pcb_addr & XSCOM_ADDR_IND_FLAG)
-		rc = xscom_indirect_write(gcid, pcb_addr, val);
-	else
-		rc = __xscom_write(gcid, pcb_addr & 0x7fffffff, val);
+	rc = __xscom_access(gcid, pcb_addr, &val, true);
 
 	/* Unlock it */
 	if (take_lock)
-		unlock(&xscom_lock);
+		unlock(l);
 	return rc;
 }
 opal_call(OPAL_XSCOM_WRITE, xscom_write, 3);
 
+/*
+ * Batched accesses: perform a list of SCOMs on one processor chip with
+ * a single lock acquisition. Stops at the first failing access and
+ * returns its error. Other partid types (Centaur, EX chiplets) are
+ * simply done one by one.
+ */
+static int xscom_multi(uint32_t partid, const uint64_t *addrs, uint64_t *vals,
+		       unsigned int count, bool is_write)
+{
+	struct lock *l;
+	unsigned int i;
+	int rc = OPAL_SUCCESS;
+
+	if (partid >> 28) {
+		for (i = 0; i < count && !rc; i++) {
+			if (is_write)
+				rc = xscom_write(partid, addrs[i], vals[i]);
+			else
+				rc = xscom_read(partid, addrs[i], &vals[i]);
+		}
+		return rc;
+	}
+	if (!xscom_gcid_ok(partid)) {
+		prerror("%s: invalid XSCOM gcid 0x%x\n", __func__, partid);
+		return OPAL_PARAMETER;
+	}
+
+	l = xscom_lock_chip(partid);
+	for (i = 0; i < count && !rc; i++)
+		rc = __xscom_access(partid, addrs[i], &vals[i], is_write);
+	unlock(l);
+
+	return rc;
+}
+
+int xscom_read_multi(uint32_t partid, const uint64_t *addrs, uint64_t *vals,
+		     unsigned int count)
+{
+	return xscom_multi(partid, addrs, vals, count, false);
+}
+
+int xscom_write_multi(uint32_t partid, const uint64_t *addrs,
+		      const uint64_t *vals, unsigned int count)
+{
+	return xscom_multi(partid, addrs, (uint64_t *)vals, count, true);
+}
+
+static int64_t opal_xscom_multi(uint32_t partid, struct opal_xscom_op *ops,
+				uint64_t count)
+{
+	struct lock *l;
+	uint64_t i, val;
+	bool is_write;
+	int64_t rc = OPAL_SUCCESS;
+
+	if (!opal_addr_valid(ops) || !count ||
+	    count > OPAL_XSCOM_MULTI_MAX_OPS)
+		return OPAL_PARAMETER;
+
+	/* Processor chips only */
+	if ((partid >> 28) || !xscom_gcid_ok(partid))
+		return OPAL_PARAMETER;
+
+	l = xscom_lock_chip(partid);
+	for (i = 0; i < count && !rc; i++) {
+		is_write = be32_to_cpu(ops[i].flags) & OPAL_XSCOM_OP_WRITE;
+		val = be64_to_cpu(ops[i].data);
+		rc = __xscom_access(partid, be64_to_cpu(ops[i].addr), &val,
+				    is_write);
+		if (!rc && !is_write)
+			ops[i].data = cpu_to_be64(val);
+		ops[i].rc = cpu_to_be32(rc);
+	}
+	unlock(l);
+
+	return rc;
+}
+opal_call(OPAL_XSCOM_MULTI, opal_xscom_multi, 3);
+
 /*
  * Perform a xscom read-modify-write.
  */
@@ -773,9 +910,48 @@ void xscom_init(void)
 		prlog(PR_DEBUG, "XSTOP: ibm,sw-checkstop-fir prop not found\n");
 }
 
+/*
+ * Switch to per-chip locking if asked to. We take every XSCOM lock
+ * so nobody is in the middle of an access while the mode changes.
+ */
+void xscom_nvram_init(void)
+{
+	struct proc_chip *chip;
+
+	if (!nvram_query_eq("xscom-lock", "per-chip"))
+		return;
+
+	lock(&xscom_lock);
+	for_each_chip(chip)
+		lock(&chip->xscom_lock);
+	xscom_per_chip_locking = true;
+	for_each_chip(chip)
+		unlock(&chip->xscom_lock);
+	unlock(&xscom_lock);
+
+	prlog(PR_NOTICE, "XSCOM: NVRAM enabled per-chip locking\n");
+}
+
+void xscom_dump_stats(void)
+{
+	struct proc_chip *chip;
+
+	for_each_chip(chip) {
+		if (!chip->xscom_ops)
+			continue;
+		prlog(PR_DEBUG, "XSCOM: Chip %x: %lld ops, %lld busy retries,"
+		      " %lld errors\n", chip->id, chip->xscom_ops,
+		      chip->xscom_retries, chip->xscom_errors);
+	}
+}
+
 void xscom_used_by_console(void)
 {
+	struct proc_chip *chip;
+
 	xscom_lock.in_con_path = true;
+	for_each_chip(chip)
+		chip->xscom_lock.in_con_path = true;
 
 	/*
 	 * Some other processor might hold it without having
@@ -784,9 +960,23 @@ void xscom_used_by_console(void)
 	 */
 	lock(&xscom_lock);
 	unlock(&xscom_lock);
+	for_each_chip(chip) {
+		lock(&chip->xscom_lock);
+		unlock(&chip->xscom_lock);
+	}
 }
 
 bool xscom_ok(void)
 {
-	return !lock_held_by_me(&xscom_lock);
+	struct proc_chip *chip;
+
+	if (lock_held_by_me(&xscom_lock))
+		return false;
+	if (!xscom_per_chip_locking)
+		return true;
+	for_each_chip(chip) {
+		if (lock_held_by_me(&chip->xscom_lock))
+			return false;
+	}
+	return true;
 }
@@ -0,0 +1,54 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __BOOTPROF_H
+#define __BOOTPROF_H
+
+#include <stdint.h>
+#include <bootprof_types.h>
+
+struct dt_node;
+
+/*
+ * Boot profile: the start and end of each step of the boot and of each
+ * CPU job run until the kernel starts. The OS finds it in
+ * /ibm,opal/firmware/exports and external/bootprof prints it.
+ */
+
+/* End the current phase (if any) and start a new one, NULL just ends */
+extern void bootprof_phase(const char *name);
+
+/* Record a CPU job that ran from start until now on this CPU */
+extern void bootprof_job(const char *name, uint64_t start);
+
+/*
+ * The chiptod sync resets the timebase. It calls these on the boot CPU
+ * right before its timebase stops and once it runs again, so that the
+ * times carry on from where they were. Jobs that end in between aren't
+ * recorded, as we can't tell which timebase they started on.
+ */
+extern void bootprof_tb_reset_begin(void);
+extern void bootprof_tb_reset_end(void);
+
+/* Start over, for fast reboot */
+extern void bootprof_reset(void);
+
+/* Stop recording when we hand over to the kernel */
+extern void bootprof_finish(void);
+
+extern void bootprof_export(struct dt_node *exports);
+
+#endif /* __BOOTPROF_H */
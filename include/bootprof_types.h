@@ -0,0 +1,57 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/* Layout of the boot profile, as read by external/bootprof */
+#ifndef __BOOTPROF_TYPES_H
+#define __BOOTPROF_TYPES_H
+
+#include <types.h>
+
+#define BOOTPROF_MAGIC		0x50524f46	/* "PROF" */
+#define BOOTPROF_VERSION	1
+
+#define BOOTPROF_NAME_LEN	32
+
+#define BOOTPROF_PHASE		1	/* Step of the boot, on the boot CPU */
+#define BOOTPROF_JOB		2	/* CPU job, on any CPU */
+
+/*
+ * The header is followed by max_entries entries, of which the first
+ * nr_entries are used. Times are in timebase ticks, but only the
+ * differences between them mean anything: the timebase is reset part
+ * way through the boot and we carry on counting from where it was.
+ */
+struct bootprof_hdr {
+	__be32 magic;
+	__be16 version;
+	__be16 entry_size;
+	__be32 max_entries;
+	__be32 nr_entries;
+	__be32 dropped;
+	__be32 reserved;
+	__be64 tb_hz;
+};
+
+/* end is 0 for a phase that's still going */
+struct bootprof_entry {
+	__be64 start;
+	__be64 end;
+	__be32 pir;
+	u8 type;
+	u8 reserved[3];
+	char name[BOOTPROF_NAME_LEN];
+};
+
+#endif /* __BOOTPROF_TYPES_H */
@@ -20,4 +20,7 @@
 /* Initialise the BT interface */
 void bt_init(void);
 
+/* Apply NVRAM settings once NVRAM is available */
+void bt_nvram_init(void);
+
 #endif
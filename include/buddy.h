@@ -40,6 +40,13 @@ struct buddy {
 	 * have there to speed up searches.
 	 */
 	unsigned int freecounts[BUDDY_MAX_ORDER + 1];
+
+	/* For each order, the lowest node that might be free. Everything
+	 * below it is known to be busy so searches can start there, which
+	 * keeps repeated allocations from rescanning the busy part of the
+	 * level every time.
+	 */
+	unsigned int freehints[BUDDY_MAX_ORDER + 1];
 	bitmap_elem_t     map[];
 };
 
@@ -178,6 +178,10 @@ struct proc_chip {
 
 	/* Used by hw/xscom.c */
 	uint64_t		xscom_base;
+	struct lock		xscom_lock;	/* per-chip locking mode */
+	uint64_t		xscom_ops;
+	uint64_t		xscom_retries;
+	uint64_t		xscom_errors;
 
 	/* Used by hw/lpc.c */
 	struct lpcm		*lpc;
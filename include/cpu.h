@@ -66,6 +66,7 @@ struct cpu_thread {
 	uint32_t			hbrt_spec_wakeup; /* primary only */
 	uint64_t			save_l2_fir_action1;
 	uint64_t			current_token;
+	uint32_t			in_opal_call;
 #ifdef STACK_CHECK_ENABLED
 	int64_t				stack_bot_mark;
 	uint64_t			stack_bot_pc;
@@ -254,6 +255,13 @@ extern void cpu_wait_job(struct cpu_job *job, bool free_it);
 extern void cpu_process_jobs(void);
 /* Fallback to running jobs synchronously for global jobs */
 extern void cpu_process_local_jobs(void);
+/*
+ * Run fn on every chip, each as a job on a different CPU when there are
+ * enough, and wait for them all. Returns false if fn failed on any chip.
+ */
+struct proc_chip;
+extern bool cpu_do_chip_jobs(const char *name,
+			     bool (*fn)(struct proc_chip *chip));
 /* Check if there's any job pending */
 bool cpu_check_jobs(struct cpu_thread *cpu);
 /* Enable/disable PM */
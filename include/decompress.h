@@ -0,0 +1,34 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __DECOMPRESS_H
+#define __DECOMPRESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <libxz/xz.h>
+
+/*
+ * Decompress the XZ stream in src into dst. If the stream was made with
+ * several blocks (xz --block-size or -T), the blocks are decompressed in
+ * parallel as CPU jobs. The decompressed size is returned in out_size.
+ *
+ * Returns 0 on success and -1 on error.
+ */
+extern int xz_decompress(void *dst, size_t dst_size, const void *src,
+			 size_t src_size, size_t *out_size);
+
+#endif /* __DECOMPRESS_H */
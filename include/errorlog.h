@@ -140,6 +140,11 @@ struct __attribute__((__packed__)) errorlog {
 
 	char user_data_dump[OPAL_LOG_MAX_DUMP];
 	struct list_node link;
+
+	/* Coalescing while queued for commit, see log_commit() */
+	uint32_t occurrences;
+	uint64_t commit_tb;
+	uint64_t last_tb;
 };
 
 struct opal_err_info {
@@ -368,5 +373,7 @@ void log_commit(struct errorlog *elog);
 void opal_elog_complete(struct errorlog *elog, bool success);
 
 int elog_init(void);
+void elog_dump_stats(void);
+void elog_flush_pending(void);
 
 #endif /* __ERRORLOG_H */
@@ -628,6 +628,9 @@ struct fsp_msg {
 	/* Response will be filed by driver when response received */
 	struct fsp_msg		*resp;
 
+	/* Timebase when queued, for latency statistics */
+	u64			tb_queued;
+
 	/* Internal queuing */
 	struct list_node	link;
 };
@@ -665,10 +668,13 @@ extern void fsp_opl(void);
 /* Check if system has an FSP */
 extern bool fsp_present(void);
 
+/* Print per command class queue statistics */
+extern void fsp_dump_stats(void);
+
 /* Allocate and populate an fsp_msg structure
  *
  * WARNING: Do _NOT_ use free() on an fsp_msg, use fsp_freemsg()
- * instead as we will eventually use pre-allocated message pools
+ * instead as messages come from a pre-allocated pool
  */
 extern struct fsp_msg *fsp_allocmsg(bool alloc_response) __warn_unused_result;
 extern struct fsp_msg *fsp_mkmsg(u32 cmd_sub_mod, u8 add_words, ...) __warn_unused_result;
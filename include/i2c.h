@@ -64,6 +64,15 @@ struct i2c_request {
 	void			(*completion)(	/* Completion callback */
 					      int rc, struct i2c_request *req);
 	void			*user_data;	/* Client data */
+
+	/*
+	 * Chained requests: segments on the same bus that the master
+	 * runs back to back, e.g. write an offset then do a number of
+	 * reads. Only the first request is queued and only its
+	 * completion is called, once the last segment is done or any
+	 * segment failed.
+	 */
+	struct i2c_request	*next;
 };
 
 /* Generic i2c */
@@ -109,6 +118,7 @@ static inline int i2c_check_quirk(struct i2c_request *req, int *rc)
 /* P8 implementation details */
 extern void p8_i2c_init(void);
 extern void p8_i2c_interrupt(uint32_t chip_id);
+extern void p8_i2c_dump_stats(void);
 
 /* P9 I2C Ownership Change OCC interrupt handler */
 extern void p9_i2c_bus_owner_change(u32 chip_id);
@@ -34,9 +34,11 @@
 #endif
 
 #if __WORDSIZE == 64
+#define PRId64 "ld"
 #define PRIu64 "lu"
 #define PRIx64 "lx"
 #else
+#define PRId64 "lld"
 #define PRIu64 "llu"
 #define PRIx64 "llx"
 #endif
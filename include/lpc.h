@@ -109,6 +109,18 @@ extern int64_t lpc_write(enum OpalLPCAddressType addr_type, uint32_t addr,
 extern int64_t lpc_read(enum OpalLPCAddressType addr_type, uint32_t addr,
 			uint32_t *data, uint32_t sz);
 
+/* Move a whole buffer, using the widest accesses the alignment allows */
+extern int64_t lpc_read_bulk(enum OpalLPCAddressType addr_type, uint32_t addr,
+			     void *buf, uint32_t len);
+extern int64_t lpc_write_bulk(enum OpalLPCAddressType addr_type, uint32_t addr,
+			      const void *buf, uint32_t len);
+
+/* Move a whole buffer through a single byte wide data port */
+extern int64_t lpc_read_fifo(enum OpalLPCAddressType addr_type, uint32_t addr,
+			     void *buf, uint32_t len);
+extern int64_t lpc_write_fifo(enum OpalLPCAddressType addr_type, uint32_t addr,
+			      const void *buf, uint32_t len);
+
 /* Mark LPC bus as used by console */
 extern void lpc_used_by_console(void);
 
@@ -71,6 +71,7 @@ extern struct mem_region skiboot_heap;
 void mem_region_init(void);
 void adjust_cpu_stacks_alloc(void);
 void mem_region_add_dt_reserved(void);
+struct dt_node *mem_region_dt_reserved_root(void);
 
 /* Mark memory as reserved */
 void mem_reserve_fw(const char *name, uint64_t start, uint64_t len);
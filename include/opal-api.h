@@ -214,7 +214,9 @@
 #define OPAL_SET_POWER_SHIFT_RATIO		155
 #define OPAL_SENSOR_GROUP_CLEAR			156
 #define OPAL_PCI_SET_P2P			157
-#define OPAL_LAST				157
+#define OPAL_XSCOM_MULTI			158
+#define OPAL_SENSOR_READ_BATCH			159
+#define OPAL_LAST				159
 
 /* Device tree flags */
 
@@ -1188,6 +1190,25 @@ struct opal_i2c_request {
 	__be64 buffer_ra;		/* Buffer real address */
 };
 
+/* OPAL_XSCOM_MULTI operation */
+struct opal_xscom_op {
+	__be64	addr;			/* SCOM address */
+	__be64	data;			/* Data to write or data read */
+	__be32	flags;
+#define OPAL_XSCOM_OP_WRITE	0x00000001
+	__be32	rc;			/* Result of that access */
+};
+#define OPAL_XSCOM_MULTI_MAX_OPS	64
+
+/* OPAL_SENSOR_READ_BATCH request */
+struct opal_sensor_read {
+	__be32	handle;			/* Sensor handle */
+	__be32	data;			/* Sensor data read */
+	__be32	rc;			/* Result of that read */
+	__be32	reserved;
+};
+#define OPAL_SENSOR_READ_BATCH_MAX	1024
+
 /* Argument to OPAL_CEC_REBOOT2() */
 enum {
 	OPAL_REBOOT_NORMAL = 0,
@@ -1253,6 +1274,7 @@ enum {
 	XIVE_DUMP_TM_USER	= 3,
 	XIVE_DUMP_VP		= 4,
 	XIVE_DUMP_EMU_STATE	= 5,
+	XIVE_DUMP_EMU_STATS	= 6,
 };
 
 /* "type" argument options for OPAL_IMC_COUNTERS_* calls */
@@ -243,6 +243,9 @@ extern int flash_subpart_info(void *part_header, uint32_t header_len,
 			      uint32_t part_size, uint32_t *part_actual,
 			      uint32_t subid, uint32_t *offset,
 			      uint32_t *size);
+extern int flash_load_xz(struct blocklevel_device *bl, uint64_t pos,
+			 uint64_t len, void *buf, size_t bufsz,
+			 size_t *out_len);
 /* NVRAM support */
 extern void nvram_init(void);
 extern void nvram_read_complete(bool success);
@@ -311,8 +314,10 @@ extern int fake_nvram_start_read(void *dst, uint32_t src, uint32_t len);
 extern int fake_nvram_write(uint32_t offset, void *src, uint32_t size);
 
 /* OCC Inband Sensors */
+struct opal_sensor_read;
 extern void occ_sensors_init(void);
 extern int occ_sensor_read(u32 handle, u32 *data);
+extern void occ_sensor_read_batch(struct opal_sensor_read *reqs, u32 count);
 extern int occ_sensor_group_clear(u32 group_hndl, int token);
 extern void occ_add_sensor_groups(struct dt_node *sg, u32  *phandles,
 				  int nr_phandles, int chipid);
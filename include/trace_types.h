@@ -25,6 +25,7 @@
 #define TRACE_FSP_MSG	4	/* FSP message sent/received */
 #define TRACE_FSP_EVENT	5	/* FSP driver event */
 #define TRACE_UART	6	/* UART driver traces */
+#define TRACE_PRLOG	7	/* Binary prlog() record */
 
 /* One per cpu, plus one for NMIs */
 struct tracebuf {
@@ -120,6 +121,26 @@ struct trace_uart {
 	__be16 in_count;
 };
 
+/*
+ * A log message recorded as the address of its format string in skiboot's
+ * image plus the raw arguments, one 64-bit slot each in data[]. Arguments
+ * with their bit set in str_mask are strings copied inline instead,
+ * NUL-terminated and padded to 8 bytes. Other %s arguments are addresses
+ * of strings in the skiboot image, like fmt.
+ */
+#define TRACE_PRLOG_MAX_ARGS	16
+#define TRACE_PRLOG_DATA_SZ	112
+
+struct trace_prlog {
+	struct trace_hdr hdr;
+	__be64 fmt;
+	u8 level;
+	u8 nargs;
+	__be16 str_mask;
+	u8 unused[4];
+	u8 data[TRACE_PRLOG_DATA_SZ];
+};
+
 union trace {
 	struct trace_hdr hdr;
 	/* Trace types go here... */
@@ -129,6 +150,7 @@ union trace {
 	struct trace_fsp_msg fsp_msg;
 	struct trace_fsp_event fsp_evt;
 	struct trace_uart uart;
+	struct trace_prlog prlog;
 };
 
 #endif /* __TRACE_TYPES_H */
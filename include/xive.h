@@ -485,6 +485,7 @@ void xive_register_ipi_source(uint32_t base, uint32_t count, void *data,
 			      const struct irq_source_ops *ops);
 
 void xive_cpu_callin(struct cpu_thread *cpu);
+void xive_reset(void);
 
 /* Get the trigger page address for an interrupt allocated with
  * xive_alloc_ipi_irqs()
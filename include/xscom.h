@@ -216,10 +216,10 @@
  */
 
 /* Use only in select places where multiple SCOMs are time/latency sensitive */
-extern void _xscom_lock(void);
+extern void _xscom_lock(uint32_t gcid);
 extern int _xscom_read(uint32_t partid, uint64_t pcb_addr, uint64_t *val, bool take_lock);
 extern int _xscom_write(uint32_t partid, uint64_t pcb_addr, uint64_t val, bool take_lock);
-extern void _xscom_unlock(void);
+extern void _xscom_unlock(uint32_t gcid);
 
 
 /* Targeted SCOM access */
@@ -232,10 +232,20 @@ static inline int xscom_write(uint32_t partid, uint64_t pcb_addr, uint64_t val)
 }
 extern int xscom_write_mask(uint32_t partid, uint64_t pcb_addr, uint64_t val, uint64_t mask);
 
+/* Perform a list of SCOMs on one chip under a single lock acquisition.
+ * Stops at, and returns the error of, the first failing access.
+ */
+extern int xscom_read_multi(uint32_t partid, const uint64_t *addrs,
+			    uint64_t *vals, unsigned int count);
+extern int xscom_write_multi(uint32_t partid, const uint64_t *addrs,
+			     const uint64_t *vals, unsigned int count);
+
 /* This chip SCOM access */
 extern int xscom_readme(uint64_t pcb_addr, uint64_t *val);
 extern int xscom_writeme(uint64_t pcb_addr, uint64_t val);
 extern void xscom_init(void);
+extern void xscom_nvram_init(void);
+extern void xscom_dump_stats(void);
 
 /* Mark XSCOM lock as being in console path */
 extern void xscom_used_by_console(void);
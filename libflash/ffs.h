@@ -63,6 +63,12 @@ enum ffs_type {
 /* Data integrity flags */
 #define FFS_ENRY_INTEG_ECC 0x8000
 
+/*
+ * User compressType definitions
+ */
+#define FFS_COMPRESSTYPE_NONE 0x00
+#define FFS_COMPRESSTYPE_XZ 0x01
+
 /*
  * User verCheck definitions
  */
@@ -108,6 +108,7 @@ static int ffs_entry_user_to_flash(struct ffs_hdr *hdr __unused,
 		struct __ffs_entry_user *dst, struct ffs_entry_user *src)
 {
 	memset(dst, 0, sizeof(struct __ffs_entry_user));
+	dst->compresstype = src->compresstype;
 	dst->datainteg = cpu_to_be16(src->datainteg);
 	dst->vercheck = src->vercheck;
 	dst->miscflags = src->miscflags;
@@ -119,6 +120,7 @@ static int ffs_entry_user_to_cpu(struct ffs_hdr *hdr __unused,
 		struct ffs_entry_user *dst, struct __ffs_entry_user *src)
 {
 	memset(dst, 0, sizeof(struct ffs_entry_user));
+	dst->compresstype = src->compresstype;
 	dst->datainteg = be16_to_cpu(src->datainteg);
 	dst->vercheck = src->vercheck;
 	dst->miscflags = src->miscflags;
@@ -211,6 +213,11 @@ bool has_ecc(struct ffs_entry *ent)
 	return ((ent->user.datainteg & FFS_ENRY_INTEG_ECC) != 0);
 }
 
+bool has_xz(struct ffs_entry *ent)
+{
+	return ent->user.compresstype == FFS_COMPRESSTYPE_XZ;
+}
+
 int ffs_init(uint32_t offset, uint32_t max_size, struct blocklevel_device *bl,
 		struct ffs_handle **ffs, bool mark_ecc)
 {
@@ -716,7 +723,7 @@ int ffs_entry_user_set(struct ffs_entry *ent, struct ffs_entry_user *user)
 	 */
 	if (user->chip)
 		return -1;
-	if (user->compresstype)
+	if (user->compresstype & ~FFS_COMPRESSTYPE_XZ)
 		return -1;
 	if (user->datainteg & ~(FFS_ENRY_INTEG_ECC))
 		return -1;
@@ -75,6 +75,12 @@ struct ffs_entry_user {
 /* Data integrity flags */
 #define FFS_ENRY_INTEG_ECC 0x8000
 
+/*
+ * User compressType definitions
+ */
+#define FFS_COMPRESSTYPE_NONE 0x00
+#define FFS_COMPRESSTYPE_XZ 0x01
+
 /*
  * User verCheck definitions
  */
@@ -92,6 +98,8 @@ struct ffs_entry_user {
 
 bool has_ecc(struct ffs_entry *ent);
 
+bool has_xz(struct ffs_entry *ent);
+
 bool has_flag(struct ffs_entry *ent, uint16_t flag);
 
 /* Init */
@@ -79,29 +79,10 @@ static int lpc_window_read(struct mbox_flash_data *mbox_flash, uint32_t pos,
 	prlog(PR_TRACE, "Reading at 0x%08x for 0x%08x offset: 0x%08x\n",
 			pos, len, off);
 
-	while(len) {
-		uint32_t chunk;
-		uint32_t dat;
-
-		/* XXX: make this read until it's aligned */
-		if (len > 3 && !(off & 3)) {
-			rc = lpc_read(OPAL_LPC_FW, off, &dat, 4);
-			if (!rc)
-				*(uint32_t *)buf = dat;
-			chunk = 4;
-		} else {
-			rc = lpc_read(OPAL_LPC_FW, off, &dat, 1);
-			if (!rc)
-				*(uint8_t *)buf = dat;
-			chunk = 1;
-		}
-		if (rc) {
-			prlog(PR_ERR, "lpc_read failure %d to FW 0x%08x\n", rc, off);
-			return rc;
-		}
-		len -= chunk;
-		off += chunk;
-		buf += chunk;
+	rc = lpc_read_bulk(OPAL_LPC_FW, off, buf, len);
+	if (rc) {
+		prlog(PR_ERR, "lpc_read failure %d to FW 0x%08x\n", rc, off);
+		return rc;
 	}
 
 	return 0;
@@ -117,25 +98,10 @@ static int lpc_window_write(struct mbox_flash_data *mbox_flash, uint32_t pos,
 	prlog(PR_TRACE, "Writing at 0x%08x for 0x%08x offset: 0x%08x\n",
 			pos, len, off);
 
-	while(len) {
-		uint32_t chunk;
-
-		if (len > 3 && !(off & 3)) {
-			rc = lpc_write(OPAL_LPC_FW, off,
-				       *(uint32_t *)buf, 4);
-			chunk = 4;
-		} else {
-			rc = lpc_write(OPAL_LPC_FW, off,
-				       *(uint8_t *)buf, 1);
-			chunk = 1;
-		}
-		if (rc) {
-			prlog(PR_ERR, "lpc_write failure %d to FW 0x%08x\n", rc, off);
-			return rc;
-		}
-		len -= chunk;
-		off += chunk;
-		buf += chunk;
+	rc = lpc_write_bulk(OPAL_LPC_FW, off, buf, len);
+	if (rc) {
+		prlog(PR_ERR, "lpc_write failure %d to FW 0x%08x\n", rc, off);
+		return rc;
 	}
 
 	return 0;
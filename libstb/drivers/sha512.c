@@ -174,14 +174,40 @@ static const uint64_t K[80] =
     UL64(0x5FCB6FAB3AD6FAEC),  UL64(0x6C44198C4A475817)
 };
 
+/*
+ * Load a big endian 64-bit word. On a big endian CPU (which is what
+ * skiboot runs as) this is a plain load rather than eight byte loads
+ * and shifts, the input is not necessarily aligned.
+ */
+static inline uint64_t sha512_load_be( const unsigned char *p )
+{
+    uint64_t v;
+
+    __builtin_memcpy( &v, p, sizeof( v ) );
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64( v );
+#endif
+    return( v );
+}
+
+/*
+ * The message schedule is kept as a rolling 16 word window rather than
+ * expanded to all 80 words up front, so it stays in registers (or at
+ * least in one cache line pair) and each word is computed by the round
+ * that uses it. Rounds are unrolled eight at a time, which lets the
+ * working variables rotate by renaming rather than by moving.
+ *
+ * skiboot is built with -mno-altivec and runs with MSR[VEC] clear, so
+ * the POWER8 vshasigmad instruction is not an option here.
+ */
 void mbedtls_sha512_process( mbedtls_sha512_context *ctx, const unsigned char data[128] )
 {
     int i;
-    uint64_t temp1, temp2, W[80];
+    uint64_t temp1, temp2, W[16];
     uint64_t A, B, C, D, E, F, G, H;
 
-#define  SHR(x,n) (x >> n)
-#define ROTR(x,n) (SHR(x,n) | (x << (64 - n)))
+#define  SHR(x,n) ((x) >> (n))
+#define ROTR(x,n) (SHR(x,n) | ((x) << (64 - (n))))
 
 #define S0(x) (ROTR(x, 1) ^ ROTR(x, 8) ^  SHR(x, 7))
 #define S1(x) (ROTR(x,19) ^ ROTR(x,61) ^  SHR(x, 6))
@@ -189,8 +215,15 @@ void mbedtls_sha512_process( mbedtls_sha512_context *ctx, const unsigned char da
 #define S2(x) (ROTR(x,28) ^ ROTR(x,34) ^ ROTR(x,39))
 #define S3(x) (ROTR(x,14) ^ ROTR(x,18) ^ ROTR(x,41))
 
-#define F0(x,y,z) ((x & y) | (z & (x | y)))
-#define F1(x,y,z) (z ^ (x & (y ^ z)))
+#define F0(x,y,z) (((x) & (y)) | ((z) & ((x) | (y))))
+#define F1(x,y,z) ((z) ^ ((x) & ((y) ^ (z))))
+
+#define R(t)                                            \
+(                                                       \
+    W[(t) & 15] += S1(W[((t) -  2) & 15]) +             \
+                   W[((t) -  7) & 15] +                 \
+                   S0(W[((t) - 15) & 15])               \
+)
 
 #define P(a,b,c,d,e,f,g,h,x,K)                  \
 {                                               \
@@ -199,16 +232,26 @@ void mbedtls_sha512_process( mbedtls_sha512_context *ctx, const unsigned char da
     d += temp1; h = temp1 + temp2;              \
 }
 
-    for( i = 0; i < 16; i++ )
-    {
-        GET_UINT64_BE( W[i], data, i << 3 );
-    }
+/*
+ * Eight rounds starting at round i, whose schedule words are j..j+7 of
+ * the window. Keeping j a constant means the window indices are too.
+ */
+#define P8(i,j,w)                                               \
+{                                                               \
+    P( A, B, C, D, E, F, G, H, w((j) + 0), K[(i) + 0] );        \
+    P( H, A, B, C, D, E, F, G, w((j) + 1), K[(i) + 1] );        \
+    P( G, H, A, B, C, D, E, F, w((j) + 2), K[(i) + 2] );        \
+    P( F, G, H, A, B, C, D, E, w((j) + 3), K[(i) + 3] );        \
+    P( E, F, G, H, A, B, C, D, w((j) + 4), K[(i) + 4] );        \
+    P( D, E, F, G, H, A, B, C, w((j) + 5), K[(i) + 5] );        \
+    P( C, D, E, F, G, H, A, B, w((j) + 6), K[(i) + 6] );        \
+    P( B, C, D, E, F, G, H, A, w((j) + 7), K[(i) + 7] );        \
+}
 
-    for( ; i < 80; i++ )
-    {
-        W[i] = S1(W[i -  2]) + W[i -  7] +
-               S0(W[i - 15]) + W[i - 16];
-    }
+#define WLOAD(t) (W[t])
+
+    for( i = 0; i < 16; i++ )
+        W[i] = sha512_load_be( data + ( i << 3 ) );
 
     A = ctx->state[0];
     B = ctx->state[1];
@@ -218,20 +261,15 @@ void mbedtls_sha512_process( mbedtls_sha512_context *ctx, const unsigned char da
     F = ctx->state[5];
     G = ctx->state[6];
     H = ctx->state[7];
-    i = 0;
 
-    do
+    P8( 0, 0, WLOAD );
+    P8( 8, 8, WLOAD );
+
+    for( i = 16; i < 80; i += 16 )
     {
-        P( A, B, C, D, E, F, G, H, W[i], K[i] ); i++;
-        P( H, A, B, C, D, E, F, G, W[i], K[i] ); i++;
-        P( G, H, A, B, C, D, E, F, W[i], K[i] ); i++;
-        P( F, G, H, A, B, C, D, E, W[i], K[i] ); i++;
-        P( E, F, G, H, A, B, C, D, W[i], K[i] ); i++;
-        P( D, E, F, G, H, A, B, C, W[i], K[i] ); i++;
-        P( C, D, E, F, G, H, A, B, W[i], K[i] ); i++;
-        P( B, C, D, E, F, G, H, A, W[i], K[i] ); i++;
+        P8( i, 0, R );
+        P8( i + 8, 8, R );
     }
-    while( i < 80 );
 
     ctx->state[0] += A;
     ctx->state[1] += B;
@@ -198,7 +198,51 @@ int stb_final(void)
 	return (failed) ? STB_MEASURE_FAILED : 0;
 }
 
+bool stb_hash_start(struct stb_hash *hash, enum resource_id id)
+{
+	memset(hash, 0, sizeof(*hash));
+	hash->active = trusted_mode && stb_resource_lookup(id) != -1;
+	if (hash->active) {
+		mbedtls_sha512_init(&hash->ctx);
+		mbedtls_sha512_starts(&hash->ctx, 0); // SHA512 = 0
+	}
+	return hash->active;
+}
+
+void stb_hash_update(struct stb_hash *hash, const void *data, size_t len)
+{
+	if (!hash->active)
+		return;
+	mbedtls_sha512_update(&hash->ctx, data, len);
+	hash->len += len;
+}
+
+void stb_hash_finish(struct stb_hash *hash)
+{
+	if (!hash->active)
+		return;
+	mbedtls_sha512_finish(&hash->ctx, hash->digest);
+	mbedtls_sha512_free(&hash->ctx);
+	hash->active = false;
+	hash->done = true;
+}
+
+static void tb_hash(const uint8_t *data, size_t len, uint8_t *digest,
+		    struct stb_hash *hash)
+{
+	if (hash && hash->done && hash->len == len)
+		memcpy(digest, hash->digest, SHA512_DIGEST_LENGTH);
+	else
+		rom_driver->sha512(data, len, digest);
+}
+
 int tb_measure(enum resource_id id, void *buf, size_t len)
+{
+	return tb_measure_hashed(id, buf, len, NULL);
+}
+
+int tb_measure_hashed(enum resource_id id, void *buf, size_t len,
+		      struct stb_hash *hash)
 {
 	int r;
 	uint8_t digest[SHA512_DIGEST_LENGTH];
@@ -247,9 +291,8 @@ int tb_measure(enum resource_id id, void *buf, size_t len)
 			abort();
 		}
 
-		rom_driver->sha512(
-			      (void*)((uint8_t*)buf + SECURE_BOOT_HEADERS_SIZE),
-			      len - SECURE_BOOT_HEADERS_SIZE, digest);
+		tb_hash((uint8_t*)buf + SECURE_BOOT_HEADERS_SIZE,
+			len - SECURE_BOOT_HEADERS_SIZE, digest, hash);
 
 		prlog(PR_INFO, "STB: %s sha512 hash re-calculated\n",
 		      resource_map[r].name);
@@ -264,7 +307,7 @@ int tb_measure(enum resource_id id, void *buf, size_t len)
 				abort();
 		}
 	} else {
-		rom_driver->sha512(buf, len, digest);
+		tb_hash(buf, len, digest, hash);
 		prlog(PR_INFO, "STB: %s sha512 hash calculated\n",
 		      resource_map[r].name);
 	}
@@ -17,6 +17,9 @@
 #ifndef __STB_H
 #define __STB_H
 
+#include "container.h"
+#include "drivers/sha512.h"
+
 /**
  * This reads secure mode and trusted mode from device tree and
  * loads drivers accordingly.
@@ -69,4 +72,42 @@ extern int sb_verify(enum resource_id id, void *buf, size_t len);
  */
 extern int tb_measure(enum resource_id id, void *buf, size_t len);
 
+/*
+ * SHA-512 of a resource computed while it is being loaded, so it can be
+ * fed one chunk at a time while the chunk is still in the cache and
+ * tb_measure_hashed() doesn't have to walk the whole image again.
+ */
+struct stb_hash {
+	mbedtls_sha512_context ctx;
+	size_t len;
+	bool active;
+	bool done;
+	uint8_t digest[SHA512_DIGEST_LENGTH];
+};
+
+/**
+ * stb_hash_start - start hashing a resource as it's loaded
+ * @hash : context, owned by the caller
+ * @id   : resource id
+ *
+ * returns: false if the resource won't be measured (trusted mode is off or
+ * it isn't mapped to a PCR), in which case the other stb_hash_*() calls do
+ * nothing.
+ */
+extern bool stb_hash_start(struct stb_hash *hash, enum resource_id id);
+extern void stb_hash_update(struct stb_hash *hash, const void *data,
+			    size_t len);
+extern void stb_hash_finish(struct stb_hash *hash);
+
+/**
+ * tb_measure_hashed - measure a resource that was hashed while loading
+ * @hash  : finished hash of what tb_measure() would have hashed, that is
+ *          the container payload or the whole of @buf
+ *
+ * Same as tb_measure(), which it falls back to if @hash is NULL or
+ * doesn't cover the same number of bytes.
+ */
+extern int tb_measure_hashed(enum resource_id id, void *buf, size_t len,
+			     struct stb_hash *hash);
+
 #endif /* __STB_H */
@@ -0,0 +1,81 @@
+/* Copyright 2017 IBM Corp.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Check the SHA-512 implementation against the FIPS-180-2 vectors and
+ * against itself fed in odd sized pieces, then time it over an image
+ * sized buffer.
+ */
+
+#include <config.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <time.h>
+
+/* The self test has a 1k buffer on the stack, that's fine here */
+#pragma GCC diagnostic ignored "-Wframe-larger-than="
+#define MBEDTLS_SELF_TEST
+#include "../drivers/sha512.c"
+
+#define BENCH_SIZE	(8 << 20)
+
+static unsigned long now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ul + ts.tv_nsec / 1000;
+}
+
+int main(void)
+{
+	unsigned char ref[64], sum[64];
+	mbedtls_sha512_context ctx;
+	unsigned char *buf;
+	unsigned long start, us;
+	size_t i, n;
+
+	assert(mbedtls_sha512_self_test(0) == 0);
+
+	buf = malloc(BENCH_SIZE);
+	assert(buf);
+	for (i = 0; i < BENCH_SIZE; i++)
+		buf[i] = rand();
+
+	start = now_us();
+	mbedtls_sha512(buf, BENCH_SIZE, ref, 0);
+	us = now_us() - start;
+
+	/* Same again through the partial block paths */
+	mbedtls_sha512_init(&ctx);
+	mbedtls_sha512_starts(&ctx, 0);
+	for (i = 0; i < BENCH_SIZE; i += n) {
+		n = 1 + rand() % 300;
+		if (n > BENCH_SIZE - i)
+			n = BENCH_SIZE - i;
+		mbedtls_sha512_update(&ctx, buf + i, n);
+	}
+	mbedtls_sha512_finish(&ctx, sum);
+	mbedtls_sha512_free(&ctx);
+	assert(memcmp(ref, sum, sizeof(sum)) == 0);
+
+	printf("SHA-512: %d MB in %lu ms, %lu MB/s\n", BENCH_SIZE >> 20,
+	       us / 1000, us ? (BENCH_SIZE * 1000000ul >> 20) / us : 0);
+
+	free(buf);
+	return 0;
+}